@@ -1,24 +1,36 @@
 #include "A-Star.h"
 
+A_STAR::A_STAR()
+{
+	verbose = true;
+	symmetry = nullptr;
+	agentSize = 1;
+	rtTick = 0;
+	rtEpoch = 1;
+
+	rtCurrent = make_pair(-1, -1);
+	rtDest = make_pair(-1, -1);
+}
+
 // A Utility Function to check whether given cell (row, col)
 // is a valid cell or not.
 bool A_STAR::isValid(int row, int col)
 {
 	// Returns true if row number and column number
 	// is in range
-	return (row >= 0) && (row < ROW) && (col >= 0)
-		&& (col < COL);
+	return (row >= 0) && (row < layout.Rows()) && (col >= 0)
+		&& (col < layout.Cols());
 }
 
 // A Utility Function to check whether the given cell is
 // blocked or not
-bool A_STAR::isUnBlocked(int grid[][COL], int row, int col)
+bool A_STAR::isUnBlocked(const cPathGrid& grid, int row, int col)
 {
-	// Returns true if the cell is not blocked else false
-	if (grid[row][col] == 1)
-		return (true);
-	else
-		return (false);
+	// Returns true if the cell is not blocked else false,
+	// bigger agents need enough room around the cell as well
+	if (agentSize > 1)
+		return grid.Clearance(row, col) >= agentSize;
+	return grid.IsWalkable(row, col);
 }
 
 // A Utility Function to check whether destination cell has
@@ -42,19 +54,23 @@ double A_STAR::calculateHValue(int row, int col, Pair dest)
 
 // A Utility Function to trace the path from the source
 // to destination
-void A_STAR::tracePath(cell cellDetails[][COL], Pair dest)
+void A_STAR::tracePath(vector<cell>& cellDetails, Pair dest)
 {
-	printf("\nThe Path is ");
+	result.found = true;
+	result.iterations = 1;
+
+	if (verbose)
+		printf("\nThe Path is ");
 	int row = dest.first;
 	int col = dest.second;
 
 	stack<Pair> Path;
 
-	while (!(cellDetails[row][col].parent_i == row
-		&& cellDetails[row][col].parent_j == col)) {
+	while (!(cellDetails[layout.Index(row, col)].parent_i == row
+		&& cellDetails[layout.Index(row, col)].parent_j == col)) {
 		Path.push(make_pair(row, col));
-		int temp_row = cellDetails[row][col].parent_i;
-		int temp_col = cellDetails[row][col].parent_j;
+		int temp_row = cellDetails[layout.Index(row, col)].parent_i;
+		int temp_col = cellDetails[layout.Index(row, col)].parent_j;
 		row = temp_row;
 		col = temp_col;
 	}
@@ -66,17 +82,29 @@ void A_STAR::tracePath(cell cellDetails[][COL], Pair dest)
 
 		path.push_back(glm::vec2(p.first, p.second));
 
-		printf("-> (%d,%d) ", p.first, p.second);
+		if (verbose)
+			printf("-> (%d,%d) ", p.first, p.second);
 	}
 
+	if (useSymmetryReduction())
+		expandMacroEdges();
+
 	return;
 }
 
 // A Function to find the shortest path between
 // a given source cell to a destination cell according
 // to A* Search Algorithm
-void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
+void A_STAR::aStarSearch(const cPathGrid& grid, Pair src, Pair dest)
 {
+	layout = grid.GetLayout();
+
+	result = sSearchResult();
+	path.clear();
+
+	searchSrc = src;
+	searchDest = dest;
+
 	// If the source is out of range
 	if (isValid(src.first, src.second) == false) {
 		printf("Source is invalid.\n");
@@ -106,40 +134,36 @@ void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
 
 	// Create a closed list and initialise it to false which
 	// means that no cell has been included yet This closed
-	// list is implemented as a boolean 2D array
-	bool closedList[ROW][COL];
-	memset(closedList, false, sizeof(closedList));
+	// list is stored in the grid's layout
+	vector<bool> closedList(layout.Size(), false);
 
-	// Declare a 2D array of structure to hold the details
-	// of that cell
-	cell cellDetails[ROW][COL];
+	// Declare an array of structure to hold the details
+	// of that cell, also in the grid's layout
+	cell emptyCell;
+	emptyCell.f = FLT_MAX;
+	emptyCell.g = FLT_MAX;
+	emptyCell.h = FLT_MAX;
+	emptyCell.parent_i = -1;
+	emptyCell.parent_j = -1;
 
-	int i, j;
+	vector<cell> cellDetails(layout.Size(), emptyCell);
 
-	for (i = 0; i < ROW; i++) {
-		for (j = 0; j < COL; j++) {
-			cellDetails[i][j].f = FLT_MAX;
-			cellDetails[i][j].g = FLT_MAX;
-			cellDetails[i][j].h = FLT_MAX;
-			cellDetails[i][j].parent_i = -1;
-			cellDetails[i][j].parent_j = -1;
-		}
-	}
+	int i, j;
 
 	// Initialising the parameters of the starting node
 	i = src.first, j = src.second;
-	cellDetails[i][j].f = 0.0;
-	cellDetails[i][j].g = 0.0;
-	cellDetails[i][j].h = 0.0;
-	cellDetails[i][j].parent_i = i;
-	cellDetails[i][j].parent_j = j;
+	cellDetails[layout.Index(i, j)].f = 0.0;
+	cellDetails[layout.Index(i, j)].g = 0.0;
+	cellDetails[layout.Index(i, j)].h = 0.0;
+	cellDetails[layout.Index(i, j)].parent_i = i;
+	cellDetails[layout.Index(i, j)].parent_j = j;
 
 	/*
 	Create an open list having information as-
 	<f, <i, j>>
 	where f = g + h,
 	and i, j are the row and column index of that cell
-	Note that 0 <= i <= ROW-1 & 0 <= j <= COL-1
+	Note that 0 <= i <= rows-1 & 0 <= j <= cols-1
 	This open list is implemented as a set of pair of
 	pair.*/
 	set<pPair> openList;
@@ -152,16 +176,67 @@ void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
 	// the destination is not reached.
 	bool foundDest = false;
 
+	// Successors when symmetry reduction is on
+	vector<Pair> successors;
+	vector<double> costs;
+
 	while (!openList.empty()) {
 		pPair p = *openList.begin();
 
 		// Remove this vertex from the open list
 		openList.erase(openList.begin());
 
-		// Add this vertex to the closed list
 		i = p.second.first;
 		j = p.second.second;
-		closedList[i][j] = true;
+
+		// With symmetry reduction the successors come from the
+		// decomposition. Macro edges have different costs, so the
+		// destination is only accepted once it is taken off the list.
+		if (useSymmetryReduction()) {
+			if (closedList[layout.Index(i, j)] == true)
+				continue;
+
+			closedList[layout.Index(i, j)] = true;
+			result.nodesExpanded++;
+
+			if (isDestination(i, j, dest) == true) {
+				if (verbose)
+					printf("The destination cell is found.\n");
+				result.pathCost = cellDetails[layout.Index(i, j)].g;
+				tracePath(cellDetails, dest);
+				foundDest = true;
+				return;
+			}
+
+			int count = getSearchSuccessors(grid, i, j, successors, costs);
+
+			for (int k = 0; k < count; k++) {
+				int index = layout.Index(successors[k].first, successors[k].second);
+
+				if (closedList[index] == true)
+					continue;
+
+				double gNew = cellDetails[layout.Index(i, j)].g + costs[k];
+				double hNew = calculateHValue(successors[k].first, successors[k].second, dest);
+				double fNew = gNew + hNew;
+
+				if (cellDetails[index].f == FLT_MAX || cellDetails[index].f > fNew) {
+					openList.insert(make_pair(fNew, successors[k]));
+
+					cellDetails[index].f = fNew;
+					cellDetails[index].g = gNew;
+					cellDetails[index].h = hNew;
+					cellDetails[index].parent_i = i;
+					cellDetails[index].parent_j = j;
+				}
+			}
+
+			continue;
+		}
+
+		// Add this vertex to the closed list
+		closedList[layout.Index(i, j)] = true;
+		result.nodesExpanded++;
 
 		/*
 		Generating all the 8 successor of this cell
@@ -196,9 +271,10 @@ void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
 			// current successor
 			if (isDestination(i - 1, j, dest) == true) {
 				// Set the Parent of the destination cell
-				cellDetails[i - 1][j].parent_i = i;
-				cellDetails[i - 1][j].parent_j = j;
-				printf("The destination cell is found.\n");
+				cellDetails[layout.Index(i - 1, j)].parent_i = i;
+				cellDetails[layout.Index(i - 1, j)].parent_j = j;
+				if (verbose)
+					printf("The destination cell is found.\n");
 				tracePath(cellDetails, dest);
 				foundDest = true;
 				return;
@@ -206,10 +282,10 @@ void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
 			// If the successor is already on the closed
 			// list or if it is blocked, then ignore it.
 			// Else do the following
-			else if (closedList[i - 1][j] == false
+			else if (closedList[layout.Index(i - 1, j)] == false
 				&& isUnBlocked(grid, i - 1, j)
 				== true) {
-				gNew = cellDetails[i][j].g + 1.0;
+				gNew = cellDetails[layout.Index(i, j)].g + 1.0;
 				hNew = calculateHValue(i - 1, j, dest);
 				fNew = gNew + hNew;
 
@@ -221,17 +297,17 @@ void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
 				// If it is on the open list already, check
 				// to see if this path to that square is
 				// better, using 'f' cost as the measure.
-				if (cellDetails[i - 1][j].f == FLT_MAX
-					|| cellDetails[i - 1][j].f > fNew) {
+				if (cellDetails[layout.Index(i - 1, j)].f == FLT_MAX
+					|| cellDetails[layout.Index(i - 1, j)].f > fNew) {
 					openList.insert(make_pair(
 						fNew, make_pair(i - 1, j)));
 
 					// Update the details of this cell
-					cellDetails[i - 1][j].f = fNew;
-					cellDetails[i - 1][j].g = gNew;
-					cellDetails[i - 1][j].h = hNew;
-					cellDetails[i - 1][j].parent_i = i;
-					cellDetails[i - 1][j].parent_j = j;
+					cellDetails[layout.Index(i - 1, j)].f = fNew;
+					cellDetails[layout.Index(i - 1, j)].g = gNew;
+					cellDetails[layout.Index(i - 1, j)].h = hNew;
+					cellDetails[layout.Index(i - 1, j)].parent_i = i;
+					cellDetails[layout.Index(i - 1, j)].parent_j = j;
 				}
 			}
 		}
@@ -244,9 +320,10 @@ void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
 			// current successor
 			if (isDestination(i + 1, j, dest) == true) {
 				// Set the Parent of the destination cell
-				cellDetails[i + 1][j].parent_i = i;
-				cellDetails[i + 1][j].parent_j = j;
-				printf("The destination cell is found.\n");
+				cellDetails[layout.Index(i + 1, j)].parent_i = i;
+				cellDetails[layout.Index(i + 1, j)].parent_j = j;
+				if (verbose)
+					printf("The destination cell is found.\n");
 				tracePath(cellDetails, dest);
 				foundDest = true;
 				return;
@@ -254,10 +331,10 @@ void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
 			// If the successor is already on the closed
 			// list or if it is blocked, then ignore it.
 			// Else do the following
-			else if (closedList[i + 1][j] == false
+			else if (closedList[layout.Index(i + 1, j)] == false
 				&& isUnBlocked(grid, i + 1, j)
 				== true) {
-				gNew = cellDetails[i][j].g + 1.0;
+				gNew = cellDetails[layout.Index(i, j)].g + 1.0;
 				hNew = calculateHValue(i + 1, j, dest);
 				fNew = gNew + hNew;
 
@@ -269,16 +346,16 @@ void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
 				// If it is on the open list already, check
 				// to see if this path to that square is
 				// better, using 'f' cost as the measure.
-				if (cellDetails[i + 1][j].f == FLT_MAX
-					|| cellDetails[i + 1][j].f > fNew) {
+				if (cellDetails[layout.Index(i + 1, j)].f == FLT_MAX
+					|| cellDetails[layout.Index(i + 1, j)].f > fNew) {
 					openList.insert(make_pair(
 						fNew, make_pair(i + 1, j)));
 					// Update the details of this cell
-					cellDetails[i + 1][j].f = fNew;
-					cellDetails[i + 1][j].g = gNew;
-					cellDetails[i + 1][j].h = hNew;
-					cellDetails[i + 1][j].parent_i = i;
-					cellDetails[i + 1][j].parent_j = j;
+					cellDetails[layout.Index(i + 1, j)].f = fNew;
+					cellDetails[layout.Index(i + 1, j)].g = gNew;
+					cellDetails[layout.Index(i + 1, j)].h = hNew;
+					cellDetails[layout.Index(i + 1, j)].parent_i = i;
+					cellDetails[layout.Index(i + 1, j)].parent_j = j;
 				}
 			}
 		}
@@ -291,9 +368,10 @@ void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
 			// current successor
 			if (isDestination(i, j + 1, dest) == true) {
 				// Set the Parent of the destination cell
-				cellDetails[i][j + 1].parent_i = i;
-				cellDetails[i][j + 1].parent_j = j;
-				printf("The destination cell is found.\n");
+				cellDetails[layout.Index(i, j + 1)].parent_i = i;
+				cellDetails[layout.Index(i, j + 1)].parent_j = j;
+				if (verbose)
+					printf("The destination cell is found.\n");
 				tracePath(cellDetails, dest);
 				foundDest = true;
 				return;
@@ -302,10 +380,10 @@ void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
 			// If the successor is already on the closed
 			// list or if it is blocked, then ignore it.
 			// Else do the following
-			else if (closedList[i][j + 1] == false
+			else if (closedList[layout.Index(i, j + 1)] == false
 				&& isUnBlocked(grid, i, j + 1)
 				== true) {
-				gNew = cellDetails[i][j].g + 1.0;
+				gNew = cellDetails[layout.Index(i, j)].g + 1.0;
 				hNew = calculateHValue(i, j + 1, dest);
 				fNew = gNew + hNew;
 
@@ -317,17 +395,17 @@ void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
 				// If it is on the open list already, check
 				// to see if this path to that square is
 				// better, using 'f' cost as the measure.
-				if (cellDetails[i][j + 1].f == FLT_MAX
-					|| cellDetails[i][j + 1].f > fNew) {
+				if (cellDetails[layout.Index(i, j + 1)].f == FLT_MAX
+					|| cellDetails[layout.Index(i, j + 1)].f > fNew) {
 					openList.insert(make_pair(
 						fNew, make_pair(i, j + 1)));
 
 					// Update the details of this cell
-					cellDetails[i][j + 1].f = fNew;
-					cellDetails[i][j + 1].g = gNew;
-					cellDetails[i][j + 1].h = hNew;
-					cellDetails[i][j + 1].parent_i = i;
-					cellDetails[i][j + 1].parent_j = j;
+					cellDetails[layout.Index(i, j + 1)].f = fNew;
+					cellDetails[layout.Index(i, j + 1)].g = gNew;
+					cellDetails[layout.Index(i, j + 1)].h = hNew;
+					cellDetails[layout.Index(i, j + 1)].parent_i = i;
+					cellDetails[layout.Index(i, j + 1)].parent_j = j;
 				}
 			}
 		}
@@ -340,9 +418,10 @@ void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
 			// current successor
 			if (isDestination(i, j - 1, dest) == true) {
 				// Set the Parent of the destination cell
-				cellDetails[i][j - 1].parent_i = i;
-				cellDetails[i][j - 1].parent_j = j;
-				printf("The destination cell is found.\n");
+				cellDetails[layout.Index(i, j - 1)].parent_i = i;
+				cellDetails[layout.Index(i, j - 1)].parent_j = j;
+				if (verbose)
+					printf("The destination cell is found.\n");
 				tracePath(cellDetails, dest);
 				foundDest = true;
 				return;
@@ -351,10 +430,10 @@ void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
 			// If the successor is already on the closed
 			// list or if it is blocked, then ignore it.
 			// Else do the following
-			else if (closedList[i][j - 1] == false
+			else if (closedList[layout.Index(i, j - 1)] == false
 				&& isUnBlocked(grid, i, j - 1)
 				== true) {
-				gNew = cellDetails[i][j].g + 1.0;
+				gNew = cellDetails[layout.Index(i, j)].g + 1.0;
 				hNew = calculateHValue(i, j - 1, dest);
 				fNew = gNew + hNew;
 
@@ -366,17 +445,17 @@ void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
 				// If it is on the open list already, check
 				// to see if this path to that square is
 				// better, using 'f' cost as the measure.
-				if (cellDetails[i][j - 1].f == FLT_MAX
-					|| cellDetails[i][j - 1].f > fNew) {
+				if (cellDetails[layout.Index(i, j - 1)].f == FLT_MAX
+					|| cellDetails[layout.Index(i, j - 1)].f > fNew) {
 					openList.insert(make_pair(
 						fNew, make_pair(i, j - 1)));
 
 					// Update the details of this cell
-					cellDetails[i][j - 1].f = fNew;
-					cellDetails[i][j - 1].g = gNew;
-					cellDetails[i][j - 1].h = hNew;
-					cellDetails[i][j - 1].parent_i = i;
-					cellDetails[i][j - 1].parent_j = j;
+					cellDetails[layout.Index(i, j - 1)].f = fNew;
+					cellDetails[layout.Index(i, j - 1)].g = gNew;
+					cellDetails[layout.Index(i, j - 1)].h = hNew;
+					cellDetails[layout.Index(i, j - 1)].parent_i = i;
+					cellDetails[layout.Index(i, j - 1)].parent_j = j;
 				}
 			}
 		}
@@ -390,9 +469,10 @@ void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
 			// current successor
 			if (isDestination(i - 1, j + 1, dest) == true) {
 				// Set the Parent of the destination cell
-				cellDetails[i - 1][j + 1].parent_i = i;
-				cellDetails[i - 1][j + 1].parent_j = j;
-				printf("The destination cell is found.\n");
+				cellDetails[layout.Index(i - 1, j + 1)].parent_i = i;
+				cellDetails[layout.Index(i - 1, j + 1)].parent_j = j;
+				if (verbose)
+					printf("The destination cell is found.\n");
 				tracePath(cellDetails, dest);
 				foundDest = true;
 				return;
@@ -401,11 +481,11 @@ void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
 			// If the successor is already on the closed
 			// list or if it is blocked, then ignore it.
 			// Else do the following
-			else if (closedList[i - 1][j + 1] == false
+			else if (closedList[layout.Index(i - 1, j + 1)] == false
 				&& isUnBlocked(grid, i - 1, j + 1) == true 
 				&& isUnBlocked(grid, i, j + 1) == true
 				&& isUnBlocked(grid, i - 1, j) == true) {
-				gNew = cellDetails[i][j].g + 1.414;
+				gNew = cellDetails[layout.Index(i, j)].g + 1.414;
 				hNew = calculateHValue(i - 1, j + 1, dest);
 				fNew = gNew + hNew;
 
@@ -417,17 +497,17 @@ void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
 				// If it is on the open list already, check
 				// to see if this path to that square is
 				// better, using 'f' cost as the measure.
-				if (cellDetails[i - 1][j + 1].f == FLT_MAX
-					|| cellDetails[i - 1][j + 1].f > fNew) {
+				if (cellDetails[layout.Index(i - 1, j + 1)].f == FLT_MAX
+					|| cellDetails[layout.Index(i - 1, j + 1)].f > fNew) {
 					openList.insert(make_pair(
 						fNew, make_pair(i - 1, j + 1)));
 
 					// Update the details of this cell
-					cellDetails[i - 1][j + 1].f = fNew;
-					cellDetails[i - 1][j + 1].g = gNew;
-					cellDetails[i - 1][j + 1].h = hNew;
-					cellDetails[i - 1][j + 1].parent_i = i;
-					cellDetails[i - 1][j + 1].parent_j = j;
+					cellDetails[layout.Index(i - 1, j + 1)].f = fNew;
+					cellDetails[layout.Index(i - 1, j + 1)].g = gNew;
+					cellDetails[layout.Index(i - 1, j + 1)].h = hNew;
+					cellDetails[layout.Index(i - 1, j + 1)].parent_i = i;
+					cellDetails[layout.Index(i - 1, j + 1)].parent_j = j;
 				}
 			}
 		}
@@ -441,9 +521,10 @@ void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
 			// current successor
 			if (isDestination(i - 1, j - 1, dest) == true) {
 				// Set the Parent of the destination cell
-				cellDetails[i - 1][j - 1].parent_i = i;
-				cellDetails[i - 1][j - 1].parent_j = j;
-				printf("The destination cell is found.\n");
+				cellDetails[layout.Index(i - 1, j - 1)].parent_i = i;
+				cellDetails[layout.Index(i - 1, j - 1)].parent_j = j;
+				if (verbose)
+					printf("The destination cell is found.\n");
 				tracePath(cellDetails, dest);
 				foundDest = true;
 				return;
@@ -452,11 +533,11 @@ void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
 			// If the successor is already on the closed
 			// list or if it is blocked, then ignore it.
 			// Else do the following
-			else if (closedList[i - 1][j - 1] == false
+			else if (closedList[layout.Index(i - 1, j - 1)] == false
 				&& isUnBlocked(grid, i - 1, j - 1) == true
 				&& isUnBlocked(grid, i, j - 1) == true
 				&& isUnBlocked(grid, i - 1, j) == true) {
-				gNew = cellDetails[i][j].g + 1.414;
+				gNew = cellDetails[layout.Index(i, j)].g + 1.414;
 				hNew = calculateHValue(i - 1, j - 1, dest);
 				fNew = gNew + hNew;
 
@@ -468,16 +549,16 @@ void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
 				// If it is on the open list already, check
 				// to see if this path to that square is
 				// better, using 'f' cost as the measure.
-				if (cellDetails[i - 1][j - 1].f == FLT_MAX
-					|| cellDetails[i - 1][j - 1].f > fNew) {
+				if (cellDetails[layout.Index(i - 1, j - 1)].f == FLT_MAX
+					|| cellDetails[layout.Index(i - 1, j - 1)].f > fNew) {
 					openList.insert(make_pair(
 						fNew, make_pair(i - 1, j - 1)));
 					// Update the details of this cell
-					cellDetails[i - 1][j - 1].f = fNew;
-					cellDetails[i - 1][j - 1].g = gNew;
-					cellDetails[i - 1][j - 1].h = hNew;
-					cellDetails[i - 1][j - 1].parent_i = i;
-					cellDetails[i - 1][j - 1].parent_j = j;
+					cellDetails[layout.Index(i - 1, j - 1)].f = fNew;
+					cellDetails[layout.Index(i - 1, j - 1)].g = gNew;
+					cellDetails[layout.Index(i - 1, j - 1)].h = hNew;
+					cellDetails[layout.Index(i - 1, j - 1)].parent_i = i;
+					cellDetails[layout.Index(i - 1, j - 1)].parent_j = j;
 				}
 			}
 		}
@@ -491,9 +572,10 @@ void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
 			// current successor
 			if (isDestination(i + 1, j + 1, dest) == true) {
 				// Set the Parent of the destination cell
-				cellDetails[i + 1][j + 1].parent_i = i;
-				cellDetails[i + 1][j + 1].parent_j = j;
-				printf("The destination cell is found.\n");
+				cellDetails[layout.Index(i + 1, j + 1)].parent_i = i;
+				cellDetails[layout.Index(i + 1, j + 1)].parent_j = j;
+				if (verbose)
+					printf("The destination cell is found.\n");
 				tracePath(cellDetails, dest);
 				foundDest = true;
 				return;
@@ -502,11 +584,11 @@ void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
 			// If the successor is already on the closed
 			// list or if it is blocked, then ignore it.
 			// Else do the following
-			else if (closedList[i + 1][j + 1] == false
+			else if (closedList[layout.Index(i + 1, j + 1)] == false
 				&& isUnBlocked(grid, i + 1, j + 1) == true
 				&& isUnBlocked(grid, i, j + 1) == true
 				&& isUnBlocked(grid, i + 1, j) == true) {
-				gNew = cellDetails[i][j].g + 1.414;
+				gNew = cellDetails[layout.Index(i, j)].g + 1.414;
 				hNew = calculateHValue(i + 1, j + 1, dest);
 				fNew = gNew + hNew;
 
@@ -518,17 +600,17 @@ void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
 				// If it is on the open list already, check
 				// to see if this path to that square is
 				// better, using 'f' cost as the measure.
-				if (cellDetails[i + 1][j + 1].f == FLT_MAX
-					|| cellDetails[i + 1][j + 1].f > fNew) {
+				if (cellDetails[layout.Index(i + 1, j + 1)].f == FLT_MAX
+					|| cellDetails[layout.Index(i + 1, j + 1)].f > fNew) {
 					openList.insert(make_pair(
 						fNew, make_pair(i + 1, j + 1)));
 
 					// Update the details of this cell
-					cellDetails[i + 1][j + 1].f = fNew;
-					cellDetails[i + 1][j + 1].g = gNew;
-					cellDetails[i + 1][j + 1].h = hNew;
-					cellDetails[i + 1][j + 1].parent_i = i;
-					cellDetails[i + 1][j + 1].parent_j = j;
+					cellDetails[layout.Index(i + 1, j + 1)].f = fNew;
+					cellDetails[layout.Index(i + 1, j + 1)].g = gNew;
+					cellDetails[layout.Index(i + 1, j + 1)].h = hNew;
+					cellDetails[layout.Index(i + 1, j + 1)].parent_i = i;
+					cellDetails[layout.Index(i + 1, j + 1)].parent_j = j;
 				}
 			}
 		}
@@ -542,9 +624,10 @@ void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
 			// current successor
 			if (isDestination(i + 1, j - 1, dest) == true) {
 				// Set the Parent of the destination cell
-				cellDetails[i + 1][j - 1].parent_i = i;
-				cellDetails[i + 1][j - 1].parent_j = j;
-				printf("The destination cell is found.\n");
+				cellDetails[layout.Index(i + 1, j - 1)].parent_i = i;
+				cellDetails[layout.Index(i + 1, j - 1)].parent_j = j;
+				if (verbose)
+					printf("The destination cell is found.\n");
 				tracePath(cellDetails, dest);
 				foundDest = true;
 				return;
@@ -553,11 +636,11 @@ void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
 			// If the successor is already on the closed
 			// list or if it is blocked, then ignore it.
 			// Else do the following
-			else if (closedList[i + 1][j - 1] == false
+			else if (closedList[layout.Index(i + 1, j - 1)] == false
 				&& isUnBlocked(grid, i + 1, j - 1) == true
 				&& isUnBlocked(grid, i, j - 1) == true
 				&& isUnBlocked(grid, i + 1, j) == true) {
-				gNew = cellDetails[i][j].g + 1.414;
+				gNew = cellDetails[layout.Index(i, j)].g + 1.414;
 				hNew = calculateHValue(i + 1, j - 1, dest);
 				fNew = gNew + hNew;
 
@@ -570,18 +653,18 @@ void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
 				// to see if this path to that square is
 				// better, using 'f' cost as the measure.
 
-				if (cellDetails[i + 1][j - 1].f == FLT_MAX
-					|| cellDetails[i + 1][j - 1].f > fNew)
+				if (cellDetails[layout.Index(i + 1, j - 1)].f == FLT_MAX
+					|| cellDetails[layout.Index(i + 1, j - 1)].f > fNew)
 				{
 					openList.insert(make_pair(
 						fNew, make_pair(i + 1, j - 1)));
 
 					// Update the details of this cell
-					cellDetails[i + 1][j - 1].f = fNew;
-					cellDetails[i + 1][j - 1].g = gNew;
-					cellDetails[i + 1][j - 1].h = hNew;
-					cellDetails[i + 1][j - 1].parent_i = i;
-					cellDetails[i + 1][j - 1].parent_j = j;
+					cellDetails[layout.Index(i + 1, j - 1)].f = fNew;
+					cellDetails[layout.Index(i + 1, j - 1)].g = gNew;
+					cellDetails[layout.Index(i + 1, j - 1)].h = hNew;
+					cellDetails[layout.Index(i + 1, j - 1)].parent_i = i;
+					cellDetails[layout.Index(i + 1, j - 1)].parent_j = j;
 				}
 			}
 		}
@@ -599,4 +682,99 @@ void A_STAR::aStarSearch(int grid[][COL], Pair src, Pair dest)
 
 vector<glm::vec2>& A_STAR::GetPath() {
 	return path;
-}
\ No newline at end of file
+}
+
+cCompactPath A_STAR::GetCompactPath() {
+	cCompactPath compact;
+	compact.Encode(path);
+	return compact;
+}
+
+void A_STAR::SetVerbose(bool verbose) {
+	this->verbose = verbose;
+}
+
+sSearchResult& A_STAR::GetSearchResult() {
+	return result;
+}
+
+// A Utility Function to collect the (up to 8) walkable successors
+// of a cell along with the cost of moving into each of them.
+// Diagonals are only allowed when both adjacent sides are open.
+int A_STAR::getSuccessors(const cPathGrid& grid, int row, int col,
+	Pair successors[8], double costs[8])
+{
+	// N, S, E, W, N.E, N.W, S.E, S.W (same order as aStarSearch)
+	static const int dRow[8] = { -1, 1, 0, 0, -1, -1, 1, 1 };
+	static const int dCol[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+
+	int count = 0;
+
+	for (int k = 0; k < 8; k++) {
+		int r = row + dRow[k];
+		int c = col + dCol[k];
+
+		if (isValid(r, c) == false || isUnBlocked(grid, r, c) == false)
+			continue;
+
+		if (k >= 4) {
+			// Can't cut the corner of a blocked cell
+			if (isUnBlocked(grid, row, c) == false
+				|| isUnBlocked(grid, r, col) == false)
+				continue;
+			costs[count] = 1.414;
+		}
+		else {
+			costs[count] = 1.0;
+		}
+
+		successors[count] = make_pair(r, c);
+		count++;
+	}
+
+	return count;
+}
+
+int A_STAR::getSearchSuccessors(const cPathGrid& grid, int row, int col,
+	vector<Pair>& successors, vector<double>& costs)
+{
+	Pair neighbours[8];
+	double neighbourCosts[8];
+
+	int count = getSuccessors(grid, row, col, neighbours, neighbourCosts);
+
+	successors.assign(neighbours, neighbours + count);
+	costs.assign(neighbourCosts, neighbourCosts + count);
+
+	if (useSymmetryReduction())
+		symmetry->ReduceSuccessors(row, col, searchSrc, searchDest, successors, costs);
+
+	return (int)successors.size();
+}
+
+void A_STAR::expandMacroEdges()
+{
+	if (path.empty())
+		return;
+
+	vector<Pair> cells;
+	cells.push_back(make_pair((int)path[0].x, (int)path[0].y));
+
+	for (int k = 1; k < path.size(); k++) {
+		cRectangularSymmetry::ExpandMacroEdge(cells.back(),
+			make_pair((int)path[k].x, (int)path[k].y), cells);
+	}
+
+	path.clear();
+	for (int k = 0; k < cells.size(); k++) {
+		path.push_back(glm::vec2(cells[k].first, cells[k].second));
+	}
+}
+
+void A_STAR::SetSymmetryReduction(const cRectangularSymmetry* symmetry) {
+	this->symmetry = symmetry;
+}
+
+void A_STAR::SetAgentSize(int size) {
+	agentSize = (size < 1) ? 1 : size;
+}
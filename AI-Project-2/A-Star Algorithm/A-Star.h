@@ -10,13 +10,12 @@
 
 #include <glm/vec2.hpp>
 
-using namespace std;
-
-#define ROW 64
-#define COL 64
+#include "cPathGrid.h"
+#include "cRectangularSymmetry.h"
+#include "cCompactPath.h"
+#include "cChunkedMap.h"
 
-// Creating a shortcut for int, int pair type
-typedef pair<int, int> Pair;
+using namespace std;
 
 // Creating a shortcut for pair<int, pair<int, int>> type
 typedef pair<double, pair<int, int> > pPair;
@@ -24,12 +23,48 @@ typedef pair<double, pair<int, int> > pPair;
 // A structure to hold the necessary parameters
 struct cell {
 	// Row and Column index of its parent
-	// Note that 0 <= i <= ROW-1 & 0 <= j <= COL-1
+	// Note that 0 <= i <= rows-1 & 0 <= j <= cols-1
 	int parent_i, parent_j;
 	// f = g + h
 	double f, g, h;
 };
 
+// Statistics of the last search that was run
+struct sSearchResult {
+	bool found = false;
+	double pathCost = 0.0;
+	unsigned int nodesExpanded = 0;
+	unsigned int iterations = 0;
+
+	// Memory-bounded search
+	size_t memoryLimitBytes = 0;
+	size_t peakMemoryBytes = 0;
+	// Expansions of cells that had already been expanded before
+	// (in an earlier iteration, or via a worse path) and were still
+	// remembered by the transposition table
+	unsigned int nodesRegenerated = 0;
+	// Transposition table entries overwritten by a different cell,
+	// anything regenerated after being evicted isn't counted above
+	unsigned int tableEvictions = 0;
+	// The search stack ran into its share of the memory cap
+	bool hitMemoryLimit = false;
+
+	// Parallel search
+	int threadsUsed = 1;
+	// Successors handed to another thread
+	unsigned int messagesSent = 0;
+
+	// Chunked search
+	// Tiles read from disk during the search
+	unsigned long long tileFaults = 0;
+	// Most tile data the map has held at once (see sChunkStats)
+	size_t peakTileBytes = 0;
+
+	// Batch search
+	// Sources that got a path, pathCost is the sum of their costs
+	unsigned int pathsFound = 0;
+};
+
 class A_STAR {
 private:
 
@@ -38,8 +73,8 @@ private:
 	bool isValid(int row, int col);
 
 	// A Utility Function to check whether the given cell is
-	// blocked or not
-	bool isUnBlocked(int grid[][COL], int row, int col);
+	// blocked or not (for the current agent size)
+	bool isUnBlocked(const cPathGrid& grid, int row, int col);
 
 	// A Utility Function to check whether destination cell has
 	// been reached or not
@@ -50,16 +85,152 @@ private:
 
 	// A Utility Function to trace the path from the source
 	// to destination
-	void tracePath(cell cellDetails[][COL], Pair dest);
+	void tracePath(vector<cell>& cellDetails, Pair dest);
+
+	// A Utility Function to collect the (up to 8) walkable successors
+	// of a cell along with the cost of moving into each of them.
+	// Diagonals are only allowed when both adjacent sides are open.
+	int getSuccessors(const cPathGrid& grid, int row, int col,
+		Pair successors[8], double costs[8]);
+
+	// Successors used by the full searches: the plain neighbours, or
+	// the reduced successors and macro edges when symmetry reduction is on
+	int getSearchSuccessors(const cPathGrid& grid, int row, int col,
+		vector<Pair>& successors, vector<double>& costs);
+
+	// Replace the macro edges of the path found with the cells they
+	// step through, so the path moves one cell at a time again
+	void expandMacroEdges();
+
+	// The decomposition only holds for agents of a single cell
+	bool useSymmetryReduction() const { return symmetry != nullptr && agentSize == 1; }
+
+	// A Utility Function to read the learned (LRTA*) heuristic of a
+	// cell, seeding it with the straight line distance on first use.
+	double getLearnedHValue(int row, int col);
 
 public:
+	A_STAR();
+
 	// A Function to find the shortest path between
 	// a given source cell to a destination cell according
 	// to A* Search Algorithm
-	void aStarSearch(int grid[][COL], Pair src, Pair dest);
+	// Per-cell search state is stored in the same cGridLayout
+	// (row-major, tiled or Morton) as the grid that is searched.
+	void aStarSearch(const cPathGrid& grid, Pair src, Pair dest);
+
+	// Memory-bounded search (IDA* with a fixed-size transposition table)
+	// The table, the search stack and the best path are allocated up
+	// front from 'memoryLimitBytes' and never grow, no matter how big the
+	// map is. The one exception is symmetry reduction, which can give a
+	// cell a few dozen successors and go past the limit by that much.
+	// Cells that don't fit in the table are simply forgotten and
+	// regenerated when the search gets back to them.
+	void memoryBoundedSearch(const cPathGrid& grid, Pair src, Pair dest,
+		size_t memoryLimitBytes);
+
+	// Hash-distributed parallel A* (HDA*)
+	// Cells are hashed to 'numThreads' workers (0 = one per core), each
+	// with its own open list. Successors owned by another worker are sent
+	// to it in batches through lock-free inboxes. The path is optimal.
+	void parallelSearch(const cPathGrid& grid, Pair src, Pair dest, int numThreads);
+
+	// Bidirectional A* (MM)
+	// Searches forward from the source and backward from the destination
+	// at the same time, meeting in the middle. Uses the MM stopping rule,
+	// so the path is still optimal.
+	void bidirectionalSearch(const cPathGrid& grid, Pair src, Pair dest);
+
+	// A* on a world paged in from disk (see cChunkedMap)
+	// Per-cell state is only kept for the cells reached, and tiles are
+	// read as the frontier gets to them, so the map never has to fit in
+	// memory. Single cell agents, no symmetry reduction.
+	void chunkedSearch(cChunkedMap& map, Pair src, Pair dest);
+
+	// Routes one agent from every source to its nearest goal, with a
+	// single search backwards from all the goals (see GetBatchPaths).
+	// Paths are optimal, no symmetry reduction.
+	void batchSearch(const cPathGrid& grid, const vector<Pair>& sources, const vector<Pair>& goals);
+
+	// Paths of the last batch search, in the order of the sources. Empty
+	// for sources that are blocked or can't reach any goal.
+	vector<cCompactPath>& GetBatchPaths();
 
 	vector<glm::vec2>& GetPath();
 
+	// The same path as a start cell and 3 bit direction codes
+	cCompactPath GetCompactPath();
+
+	// Print progress and the path found to the console (on by default)
+	void SetVerbose(bool verbose);
+
+	// Rectangular symmetry reduction for aStarSearch, memoryBoundedSearch,
+	// parallelSearch and bidirectionalSearch (nullptr turns it off).
+	// It has to be built from the grid that is searched. Real-time search
+	// moves one cell per tick, so it always uses the plain neighbours.
+	void SetSymmetryReduction(const cRectangularSymmetry* symmetry);
+
+	// Size of the agent's square footprint in cells (1 by default).
+	// Cells are the top left corner of the footprint, and the ones with
+	// a clearance below the size are treated as blocked by every search,
+	// so the grid's clearance has to be up to date (UpdateClearance).
+	// Symmetry reduction is skipped for agents bigger than one cell.
+	void SetAgentSize(int size);
+
+	sSearchResult& GetSearchResult();
+
+	// Real-time search (LSS-LRTA*)
+	// The agent does not wait for a full path. Every tick it runs an
+	// A* lookahead limited to 'lookahead' expansions around its current
+	// cell, raises the learned heuristic of the cells it expanded and
+	// commits to a single move. Per-tick work only depends on the
+	// lookahead, never on the size of the map.
+	void InitRealTimeSearch(const cPathGrid& grid, Pair src, Pair dest);
+
+	// Returns false once the destination is reached, or when there is
+	// no way out of the current cell. Otherwise 'nextCell' is the cell
+	// the agent moved to during this tick.
+	bool RealTimeStep(const cPathGrid& grid, int lookahead, Pair& nextCell);
+
+	Pair GetRealTimePosition();
+
+	// Learned values stay admissible when walls are added, but can
+	// overestimate once one is removed. Drops them all in O(1), the
+	// agent keeps its position and destination.
+	void ForgetLearnedHeuristic();
+
 private:
 	vector<glm::vec2> path;
+	vector<cCompactPath> batchPaths;
+	sSearchResult result;
+	bool verbose;
+
+	// Layout of the grid being searched, per-cell state uses it too
+	cGridLayout layout;
+
+	int agentSize;
+
+	// Symmetry reduction, along with the source and destination of the
+	// current search (they may sit inside a rectangle)
+	const cRectangularSymmetry* symmetry;
+	Pair searchSrc;
+	Pair searchDest;
+
+	// Learned heuristic values, persisted between ticks (and trials).
+	// Entries are only learned when their epoch matches the current one,
+	// so they can all be forgotten at once.
+	vector<double> learnedH;
+	vector<unsigned int> learnedEpoch;
+	unsigned int rtEpoch;
+
+	// Per-tick lookahead scratch. Entries are only valid when their
+	// stamp matches the current tick, so nothing is cleared between ticks.
+	vector<unsigned int> rtStamp;
+	unsigned int rtTick;
+	vector<double> rtG;
+	vector<Pair> rtParent;
+	vector<bool> rtClosed;
+
+	Pair rtCurrent;
+	Pair rtDest;
 };
\ No newline at end of file
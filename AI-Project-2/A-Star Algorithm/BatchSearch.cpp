@@ -0,0 +1,137 @@
+#include "A-Star.h"
+
+#include <queue>
+#include <functional>
+#include <cfloat>
+
+// Routes a whole group of agents to a shared set of goals
+//
+// Instead of one A* per agent, a single Dijkstra runs backwards from
+// every goal at once (all of them seeded at cost 0) and stops as soon as
+// every source has been settled. Moves and costs are the same in both
+// directions (diagonals check both sides of the corner), so each settled
+// cell ends up with the cost to its nearest goal and the neighbour that
+// leads there. An agent's path is then just a walk along those
+// neighbours. The search costs about as much as the longest route on its
+// own, no matter how many agents there are.
+
+void A_STAR::batchSearch(const cPathGrid& grid, const vector<Pair>& sources, const vector<Pair>& goals)
+{
+	layout = grid.GetLayout();
+	result = sSearchResult();
+	path.clear();
+	batchPaths.assign(sources.size(), cCompactPath());
+
+	size_t cellCount = layout.Size();
+
+	vector<double> g(cellCount, DBL_MAX);
+	// Next cell on the way to the nearest goal, -1 on the goals
+	vector<int> next(cellCount, -1);
+	vector<bool> closed(cellCount, false);
+
+	// Cells the search has to settle before it can stop
+	vector<bool> isSource(cellCount, false);
+	size_t sourcesLeft = 0;
+
+	for (size_t k = 0; k < sources.size(); k++) {
+		Pair src = sources[k];
+
+		if (isValid(src.first, src.second) == false || isUnBlocked(grid, src.first, src.second) == false) {
+			if (verbose)
+				printf("Source (%d,%d) is invalid or blocked.\n", src.first, src.second);
+			continue;
+		}
+
+		int index = layout.Index(src.first, src.second);
+		if (!isSource[index]) {
+			isSource[index] = true;
+			sourcesLeft++;
+		}
+	}
+
+	// <g, <i, j>>, stale entries are skipped when they come up
+	priority_queue<pPair, vector<pPair>, greater<pPair> > openList;
+
+	for (size_t k = 0; k < goals.size(); k++) {
+		Pair goal = goals[k];
+
+		if (isValid(goal.first, goal.second) == false || isUnBlocked(grid, goal.first, goal.second) == false)
+			continue;
+
+		int index = layout.Index(goal.first, goal.second);
+		if (g[index] != 0.0) {
+			g[index] = 0.0;
+			openList.push(make_pair(0.0, goal));
+		}
+	}
+
+	Pair successors[8];
+	double costs[8];
+
+	while (!openList.empty() && sourcesLeft > 0) {
+		pPair p = openList.top();
+		openList.pop();
+
+		int i = p.second.first;
+		int j = p.second.second;
+		int index = layout.Index(i, j);
+
+		if (closed[index])
+			continue;
+
+		closed[index] = true;
+		result.nodesExpanded++;
+
+		if (isSource[index])
+			sourcesLeft--;
+
+		int count = getSuccessors(grid, i, j, successors, costs);
+
+		for (int k = 0; k < count; k++) {
+			int succIndex = layout.Index(successors[k].first, successors[k].second);
+			if (closed[succIndex])
+				continue;
+
+			double gNew = g[index] + costs[k];
+			if (gNew < g[succIndex]) {
+				g[succIndex] = gNew;
+				next[succIndex] = index;
+				openList.push(make_pair(gNew, successors[k]));
+			}
+		}
+	}
+
+	// Walk every source down to its goal
+	for (size_t k = 0; k < sources.size(); k++) {
+		Pair src = sources[k];
+
+		if (isValid(src.first, src.second) == false)
+			continue;
+
+		int index = layout.Index(src.first, src.second);
+		if (!isSource[index] || !closed[index])
+			continue;
+
+		cCompactPath& route = batchPaths[k];
+		route.SetStart(src);
+
+		while (next[index] != -1) {
+			index = next[index];
+			route.Append(layout.Coordinates(index));
+		}
+
+		result.pathsFound++;
+		result.pathCost += g[layout.Index(src.first, src.second)];
+	}
+
+	result.found = result.pathsFound > 0;
+	result.iterations = 1;
+
+	if (verbose)
+		printf("Routed %u of %d agents to %d goals, %u cells expanded\n",
+			result.pathsFound, (int)sources.size(), (int)goals.size(), result.nodesExpanded);
+}
+
+vector<cCompactPath>& A_STAR::GetBatchPaths() {
+	return batchPaths;
+}
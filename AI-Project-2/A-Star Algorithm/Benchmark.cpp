@@ -0,0 +1,189 @@
+#include "Benchmark.h"
+
+#include "A-Star.h"
+
+#include <chrono>
+#include <random>
+#include <cstdio>
+
+// Share of the cells that are walls on the benchmark maps
+static const double WALL_DENSITY = 0.25;
+
+static const char* layoutName(eGridLayout layout)
+{
+	switch (layout)
+	{
+		case TILED_LAYOUT:
+			return "tiled 8x8";
+		case MORTON_LAYOUT:
+			return "morton";
+		default:
+			return "row-major";
+	}
+}
+
+// A random open cell
+static Pair randomOpenCell(const cPathGrid& grid, std::mt19937& rng)
+{
+	std::uniform_int_distribution<int> row(0, grid.Rows() - 1);
+	std::uniform_int_distribution<int> col(0, grid.Cols() - 1);
+
+	while (true) {
+		Pair p = make_pair(row(rng), col(rng));
+		if (grid.IsWalkable(p.first, p.second))
+			return p;
+	}
+}
+
+void BenchmarkGridLayouts(int rows, int cols, int queries)
+{
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<double> chance(0.0, 1.0);
+
+	// One map, copied into every layout
+	cPathGrid grid(rows, cols, ROW_MAJOR_LAYOUT);
+	for (int i = 0; i < rows; i++) {
+		for (int j = 0; j < cols; j++) {
+			grid.SetWalkable(i, j, chance(rng) >= WALL_DENSITY);
+		}
+	}
+
+	vector<pair<Pair, Pair> > trips;
+	for (int q = 0; q < queries; q++) {
+		Pair src = randomOpenCell(grid, rng);
+		Pair dest = randomOpenCell(grid, rng);
+		trips.push_back(make_pair(src, dest));
+	}
+
+	const eGridLayout layouts[] = { ROW_MAJOR_LAYOUT, TILED_LAYOUT, MORTON_LAYOUT };
+	const char* modes[] = { "A*", "A* + RSR", "Bidirectional", "Parallel" };
+
+	printf("Grid layout benchmark: %d x %d cells, %d queries\n", rows, cols, queries);
+
+	for (int l = 0; l < 3; l++) {
+		grid.ChangeLayout(layouts[l]);
+
+		cRectangularSymmetry symmetry;
+		symmetry.Build(grid);
+
+		for (int m = 0; m < 4; m++) {
+			A_STAR aStar;
+			aStar.SetVerbose(false);
+
+			if (m == 1)
+				aStar.SetSymmetryReduction(&symmetry);
+
+			unsigned int expanded = 0;
+			int found = 0;
+
+			auto start = std::chrono::high_resolution_clock::now();
+
+			for (int q = 0; q < queries; q++) {
+				switch (m)
+				{
+					case 0:
+					case 1:
+						aStar.aStarSearch(grid, trips[q].first, trips[q].second);
+						break;
+					case 2:
+						aStar.bidirectionalSearch(grid, trips[q].first, trips[q].second);
+						break;
+					default:
+						aStar.parallelSearch(grid, trips[q].first, trips[q].second, 0);
+						break;
+				}
+
+				expanded += aStar.GetSearchResult().nodesExpanded;
+				if (aStar.GetSearchResult().found)
+					found++;
+			}
+
+			auto end = std::chrono::high_resolution_clock::now();
+			double ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+			printf("  %-10s %-14s %9.2f ms total, %8.3f ms/query, %u expanded, %d/%d found\n",
+				layoutName(layouts[l]), modes[m], ms, ms / queries, expanded, found, queries);
+		}
+	}
+}
+
+// Walls of the chunked benchmark world, hashed from the cell so the
+// world never has to exist in memory
+static bool isOpenWorldCell(int row, int col)
+{
+	unsigned int h = (unsigned int)row * 0x9e3779b1u ^ (unsigned int)col * 0x85ebca6bu;
+	h ^= h >> 15;
+	h *= 0x2c1b3c6du;
+	h ^= h >> 12;
+	return (h % 1000) >= (unsigned int)(WALL_DENSITY * 1000);
+}
+
+void BenchmarkChunkedMap(int rows, int cols, size_t budgetBytes, int queries)
+{
+	const char* fileName = "benchmark_world.tiles";
+
+	// Trips are kept short enough for a plain A*, but long enough to
+	// cross plenty of tiles
+	const int TRIP_LENGTH = 1000;
+
+	printf("Chunked map benchmark: %d x %d cells, %zu KB tile budget, %d queries\n",
+		rows, cols, budgetBytes / 1024, queries);
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	if (!cChunkedMap::Create(fileName, rows, cols, isOpenWorldCell)) {
+		printf("  Could not write %s\n", fileName);
+		return;
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	printf("  wrote the tile file in %.0f ms\n", std::chrono::duration<double, std::milli>(end - start).count());
+
+	cChunkedMap map;
+	if (!map.Open(fileName, budgetBytes)) {
+		printf("  %s\n", map.getLastError().c_str());
+		return;
+	}
+
+	std::mt19937 rng(1234);
+	std::uniform_int_distribution<int> row(0, rows - 1);
+	std::uniform_int_distribution<int> col(0, cols - 1);
+	std::uniform_int_distribution<int> offset(-TRIP_LENGTH, TRIP_LENGTH);
+
+	A_STAR aStar;
+	aStar.SetVerbose(false);
+
+	unsigned int expanded = 0;
+	int found = 0;
+	double ms = 0.0;
+
+	for (int q = 0; q < queries; q++) {
+		Pair src, dest;
+		do {
+			src = make_pair(row(rng), col(rng));
+		} while (!map.IsWalkable(src.first, src.second));
+		do {
+			dest = make_pair(src.first + offset(rng), src.second + offset(rng));
+		} while (!map.IsInside(dest.first, dest.second) || !map.IsWalkable(dest.first, dest.second));
+
+		start = std::chrono::high_resolution_clock::now();
+		aStar.chunkedSearch(map, src, dest);
+		end = std::chrono::high_resolution_clock::now();
+
+		ms += std::chrono::duration<double, std::milli>(end - start).count();
+		expanded += aStar.GetSearchResult().nodesExpanded;
+		if (aStar.GetSearchResult().found)
+			found++;
+	}
+
+	const sChunkStats& stats = map.GetStats();
+
+	printf("  %9.2f ms total, %8.3f ms/query, %u expanded, %d/%d found\n",
+		ms, ms / queries, expanded, found, queries);
+	printf("  %llu tile faults, %llu hits, %llu evictions, %zu KB resident (peak %zu KB)\n",
+		stats.tileFaults, stats.tileHits, stats.evictions,
+		stats.residentBytes / 1024, stats.peakResidentBytes / 1024);
+
+	map.Close();
+	remove(fileName);
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+
+// Times every search mode on the same random 'rows' x 'cols' maps,
+// once per grid layout, and prints the results to the console.
+// Each layout answers the same 'queries' source/destination pairs.
+void BenchmarkGridLayouts(int rows, int cols, int queries);
+
+// Writes a random 'rows' x 'cols' world to a tile file and runs
+// 'queries' chunked searches on it, with at most 'budgetBytes' of tiles
+// in memory. Prints the timings and the tile paging statistics.
+void BenchmarkChunkedMap(int rows, int cols, size_t budgetBytes, int queries);
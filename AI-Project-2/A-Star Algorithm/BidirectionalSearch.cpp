@@ -0,0 +1,241 @@
+#include "A-Star.h"
+
+#include <cfloat>
+#include <cmath>
+
+// Bidirectional A* (MM)
+//
+// One search runs forward from the source, the other backward from the
+// destination, each with a front-to-end heuristic (distance to the other
+// end). Nodes are prioritised by pr(n) = max(f(n), 2g(n)), which makes
+// both searches meet in the middle: neither one expands a node past the
+// midpoint of the optimal path. The search stops once the best path seen
+// through a meeting cell (U) can't be beaten:
+//
+//     U <= max(C, fminF, fminB, gminF + gminB + eps)
+//
+// where C is the smallest priority on either open list and eps is the
+// cheapest move. On long corridors that end in dead end regions only one
+// side has to flood them, instead of the single direction search always
+// getting lured in.
+
+// Cheapest move on the grid
+static const double MIN_EDGE_COST = 1.0;
+
+// State of one search direction
+struct sSearchDirection {
+	vector<double> g;
+	vector<int> parentKey;
+	vector<bool> closed;
+
+	// Open list ordered three ways, the stopping rule needs all of them
+	set<pPair> byPriority;
+	set<pPair> byF;
+	set<pPair> byG;
+
+	// Priority and 'f' each open cell was inserted with
+	vector<double> openPriority;
+	vector<double> openF;
+
+	const cGridLayout& layout;
+
+	sSearchDirection(const cGridLayout& layout)
+		: g(layout.Size(), DBL_MAX)
+		, parentKey(layout.Size(), -1)
+		, closed(layout.Size(), false)
+		, openPriority(layout.Size(), 0.0)
+		, openF(layout.Size(), 0.0)
+		, layout(layout)
+	{
+	}
+
+	void Push(Pair cell, double gValue, double h)
+	{
+		int key = layout.Index(cell.first, cell.second);
+		double f = gValue + h;
+		double priority = (f > 2.0 * gValue) ? f : 2.0 * gValue;
+
+		g[key] = gValue;
+		openPriority[key] = priority;
+		openF[key] = f;
+
+		byPriority.insert(make_pair(priority, cell));
+		byF.insert(make_pair(f, cell));
+		byG.insert(make_pair(gValue, cell));
+	}
+
+	void Remove(Pair cell)
+	{
+		int key = layout.Index(cell.first, cell.second);
+
+		byPriority.erase(make_pair(openPriority[key], cell));
+		byF.erase(make_pair(openF[key], cell));
+		byG.erase(make_pair(g[key], cell));
+	}
+
+	bool IsOpen(int key)
+	{
+		return g[key] != DBL_MAX && !closed[key];
+	}
+};
+
+void A_STAR::bidirectionalSearch(const cPathGrid& grid, Pair src, Pair dest)
+{
+	layout = grid.GetLayout();
+
+	result = sSearchResult();
+	path.clear();
+
+	searchSrc = src;
+	searchDest = dest;
+
+	// If the source or the destination is out of range
+	if (isValid(src.first, src.second) == false
+		|| isValid(dest.first, dest.second) == false) {
+		printf("Source or destination is invalid.\n");
+		return;
+	}
+
+	// Either the source or the destination is blocked
+	if (isUnBlocked(grid, src.first, src.second) == false
+		|| isUnBlocked(grid, dest.first, dest.second) == false) {
+		printf("Source or the destination is blocked.\n");
+		return;
+	}
+
+	// If the destination cell is the same as source cell
+	if (isDestination(src.first, src.second, dest) == true) {
+		printf("We are already at the destination.\n");
+		result.found = true;
+		path.push_back(glm::vec2(src.first, src.second));
+		return;
+	}
+
+	sSearchDirection forward(layout);
+	sSearchDirection backward(layout);
+
+	int srcKey = layout.Index(src.first, src.second);
+	int destKey = layout.Index(dest.first, dest.second);
+
+	forward.Push(src, 0.0, calculateHValue(src.first, src.second, dest));
+	forward.parentKey[srcKey] = srcKey;
+
+	backward.Push(dest, 0.0, calculateHValue(dest.first, dest.second, src));
+	backward.parentKey[destKey] = destKey;
+
+	// Cost of the best path found so far, and where the two halves meet
+	double bestCost = DBL_MAX;
+	int meetKey = -1;
+
+	vector<Pair> successors;
+	vector<double> costs;
+
+	while (!forward.byPriority.empty() && !backward.byPriority.empty()) {
+		double minPriorityF = forward.byPriority.begin()->first;
+		double minPriorityB = backward.byPriority.begin()->first;
+
+		double C = (minPriorityF < minPriorityB) ? minPriorityF : minPriorityB;
+
+		// Stopping rule
+		double bound = C;
+		if (forward.byF.begin()->first > bound)
+			bound = forward.byF.begin()->first;
+		if (backward.byF.begin()->first > bound)
+			bound = backward.byF.begin()->first;
+		if (forward.byG.begin()->first + backward.byG.begin()->first + MIN_EDGE_COST > bound)
+			bound = forward.byG.begin()->first + backward.byG.begin()->first + MIN_EDGE_COST;
+
+		if (bestCost <= bound + 1e-9)
+			break;
+
+		// Expand from the side holding the smallest priority
+		bool isForward = (minPriorityF <= minPriorityB);
+
+		sSearchDirection& current = isForward ? forward : backward;
+		sSearchDirection& other = isForward ? backward : forward;
+		Pair target = isForward ? dest : src;
+
+		Pair cell = current.byPriority.begin()->second;
+		int key = layout.Index(cell.first, cell.second);
+
+		current.Remove(cell);
+		current.closed[key] = true;
+		result.nodesExpanded++;
+
+		int count = getSearchSuccessors(grid, cell.first, cell.second, successors, costs);
+
+		for (int k = 0; k < count; k++) {
+			int succKey = layout.Index(successors[k].first, successors[k].second);
+			double gNew = current.g[key] + costs[k];
+
+			if (gNew >= current.g[succKey])
+				continue;
+
+			// Found a cheaper way, reopen the cell if needed
+			if (current.IsOpen(succKey))
+				current.Remove(successors[k]);
+			current.closed[succKey] = false;
+
+			current.parentKey[succKey] = key;
+			current.Push(successors[k], gNew,
+				calculateHValue(successors[k].first, successors[k].second, target));
+
+			// Did the two searches meet here?
+			if (other.g[succKey] != DBL_MAX && gNew + other.g[succKey] < bestCost) {
+				bestCost = gNew + other.g[succKey];
+				meetKey = succKey;
+			}
+		}
+	}
+
+	if (meetKey == -1) {
+		printf("Failed to find the Destination Cell.\n");
+		return;
+	}
+
+	result.found = true;
+	result.pathCost = bestCost;
+	result.iterations = 1;
+
+	// Source -> meeting cell, built back to front
+	stack<Pair> Path;
+	int key = meetKey;
+	while (key != srcKey) {
+		Path.push(layout.Coordinates(key));
+		key = forward.parentKey[key];
+	}
+	Path.push(src);
+
+	if (verbose) {
+		printf("The destination cell is found.\n");
+		printf("\nThe Path is ");
+	}
+
+	while (!Path.empty()) {
+		Pair p = Path.top();
+		Path.pop();
+
+		path.push_back(glm::vec2(p.first, p.second));
+
+		if (verbose)
+			printf("-> (%d,%d) ", p.first, p.second);
+	}
+
+	// Meeting cell -> destination, already in order
+	key = meetKey;
+	while (key != destKey) {
+		key = backward.parentKey[key];
+
+		Pair p = layout.Coordinates(key);
+		path.push_back(glm::vec2(p.first, p.second));
+
+		if (verbose)
+			printf("-> (%d,%d) ", p.first, p.second);
+	}
+
+	if (useSymmetryReduction())
+		expandMacroEdges();
+
+	if (verbose)
+		printf("\nExpanded: %u\n", result.nodesExpanded);
+}
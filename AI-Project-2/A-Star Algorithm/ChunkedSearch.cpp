@@ -0,0 +1,159 @@
+#include "A-Star.h"
+
+#include <queue>
+#include <functional>
+#include <unordered_map>
+#include <cmath>
+
+// A* on a cChunkedMap
+//
+// Same moves, costs and heuristic as aStarSearch, but nothing is sized
+// by the map: per-cell state only exists for the cells the search has
+// reached, and walkability is read through the map's tile cache, so
+// tiles are paged in as the frontier reaches them and dropped again once
+// it has moved on. Memory grows with the area searched, not the world.
+
+// What the search knows about a cell it has reached
+struct sChunkNode {
+	double g;
+	long long parent;
+	bool closed;
+};
+
+// Cells are keyed by their row-major number, maps can hold more than
+// 2^31 cells
+static long long cellKey(const cChunkedMap& map, int row, int col)
+{
+	return (long long)row * map.Cols() + col;
+}
+
+// Rows and columns of big maps overflow an int once squared
+static double distance(int row, int col, Pair dest)
+{
+	double dRow = (double)row - dest.first;
+	double dCol = (double)col - dest.second;
+	return sqrt(dRow * dRow + dCol * dCol);
+}
+
+void A_STAR::chunkedSearch(cChunkedMap& map, Pair src, Pair dest)
+{
+	result = sSearchResult();
+	path.clear();
+
+	sChunkStats before = map.GetStats();
+
+	if (!map.IsInside(src.first, src.second) || !map.IsInside(dest.first, dest.second)) {
+		printf("Source or destination is invalid.\n");
+		return;
+	}
+
+	if (!map.IsWalkable(src.first, src.second) || !map.IsWalkable(dest.first, dest.second)) {
+		printf("Source or the destination is blocked.\n");
+		return;
+	}
+
+	if (isDestination(src.first, src.second, dest) == true) {
+		printf("We are already at the destination.\n");
+		result.found = true;
+		path.push_back(glm::vec2(src.first, src.second));
+		return;
+	}
+
+	// N, S, E, W, N.E, N.W, S.E, S.W (same order as aStarSearch)
+	static const int dRow[8] = { -1, 1, 0, 0, -1, -1, 1, 1 };
+	static const int dCol[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+
+	unordered_map<long long, sChunkNode> nodes;
+
+	sChunkNode start = { 0.0, -1, false };
+	nodes[cellKey(map, src.first, src.second)] = start;
+
+	// <f, <i, j>>, stale entries are skipped when they come up
+	priority_queue<pPair, vector<pPair>, greater<pPair> > openList;
+	openList.push(make_pair(distance(src.first, src.second, dest), src));
+
+	while (!openList.empty()) {
+		pPair p = openList.top();
+		openList.pop();
+
+		int i = p.second.first;
+		int j = p.second.second;
+		sChunkNode& node = nodes[cellKey(map, i, j)];
+
+		if (node.closed)
+			continue;
+
+		node.closed = true;
+		result.nodesExpanded++;
+
+		if (isDestination(i, j, dest) == true) {
+			if (verbose)
+				printf("The destination cell is found\n");
+
+			result.found = true;
+			result.iterations = 1;
+			result.pathCost = node.g;
+
+			// Walk the parents back to the source
+			vector<Pair> cells;
+			long long key = cellKey(map, i, j);
+			while (key != -1) {
+				cells.push_back(make_pair((int)(key / map.Cols()), (int)(key % map.Cols())));
+				key = nodes[key].parent;
+			}
+
+			if (verbose)
+				printf("\nThe Path is ");
+
+			for (int k = (int)cells.size() - 1; k >= 0; k--) {
+				path.push_back(glm::vec2(cells[k].first, cells[k].second));
+
+				if (verbose)
+					printf("-> (%d,%d) ", cells[k].first, cells[k].second);
+			}
+			break;
+		}
+
+		double g = node.g;
+		long long parent = cellKey(map, i, j);
+
+		for (int k = 0; k < 8; k++) {
+			int r = i + dRow[k];
+			int c = j + dCol[k];
+
+			// Reading the cell pages its tile in
+			if (!map.IsInside(r, c) || !map.IsWalkable(r, c))
+				continue;
+
+			// Can't cut the corner of a blocked cell
+			if (k >= 4 && (!map.IsWalkable(i, c) || !map.IsWalkable(r, j)))
+				continue;
+
+			double gNew = g + ((k >= 4) ? 1.414 : 1.0);
+
+			long long key = cellKey(map, r, c);
+			unordered_map<long long, sChunkNode>::iterator it = nodes.find(key);
+
+			if (it == nodes.end()) {
+				sChunkNode reached = { gNew, parent, false };
+				nodes[key] = reached;
+			}
+			else if (!it->second.closed && gNew < it->second.g) {
+				it->second.g = gNew;
+				it->second.parent = parent;
+			}
+			else {
+				continue;
+			}
+
+			openList.push(make_pair(gNew + distance(r, c, dest), make_pair(r, c)));
+		}
+	}
+
+	if (!result.found && verbose)
+		printf("Failed to find the Destination Cell\n");
+
+	const sChunkStats& after = map.GetStats();
+	result.tileFaults = after.tileFaults - before.tileFaults;
+	result.peakTileBytes = after.peakResidentBytes;
+}
@@ -0,0 +1,329 @@
+#include "A-Star.h"
+
+#include <cfloat>
+#include <cmath>
+
+// Memory-bounded search (IDA* with a fixed-size transposition table)
+//
+// Instead of a cellDetails entry for every cell of the map, the search
+// only keeps the current depth first path plus a transposition table of
+// a fixed size. The table remembers the best 'g' each cell was reached
+// with during the current iteration, which cuts away the duplicate paths
+// that make plain IDA* useless on grids. When the table is full, old
+// entries are overwritten and those cells get regenerated later on.
+//
+// With 1.0/1.414 move costs and a straight line heuristic nearly every
+// 'f' is unique, so growing the threshold to the smallest 'f' that was
+// cut off means thousands of iterations. The threshold grows by at least
+// THRESHOLD_STEP instead, and the last iteration keeps going as a depth
+// first branch and bound after the first hit so the path stays optimal.
+
+// A transposition table slot
+struct sTableEntry {
+	int key;					// layout.Index(row, col), -1 when empty
+	unsigned int iteration;		// iteration that wrote the entry
+	double g;					// best 'g' seen for this cell
+};
+
+// One level of the depth first search stack. Its successors sit in a
+// pool shared by the whole stack, with symmetry reduction a cell can
+// have a lot more than 8 of them.
+struct sSearchFrame {
+	Pair cell;
+	double g;
+	int first;					// first successor in the pool
+	int next;					// next successor to try
+	int count;
+};
+
+// Pool bytes taken by one successor
+static const size_t SUCCESSOR_BYTES = sizeof(Pair) + sizeof(double);
+
+// Bytes of one level of the stack: its frame, and its cell in the best path
+static const size_t FRAME_BYTES = sizeof(sSearchFrame) + sizeof(Pair);
+
+// Successors per level the stack's share is split for, cells only have
+// more with symmetry reduction
+static const size_t SUCCESSORS_PER_FRAME = 8;
+
+// Share of the memory cap given to the transposition table,
+// the rest is left for the search stack
+static const double TABLE_SHARE = 0.75;
+
+// Minimum growth of the 'f' threshold between iterations (one straight move)
+static const double THRESHOLD_STEP = 1.0;
+
+// The table is 2-way set associative. Returns the slot holding 'key', or
+// the slot to overwrite: an empty one, one left over from an older
+// iteration, or else the one with the larger 'g' (entries close to the
+// source prune the most).
+static sTableEntry& probeTable(vector<sTableEntry>& table, int key,
+	unsigned int mask, unsigned int iteration)
+{
+	unsigned int slot = ((unsigned int)key * 2654435761u) & mask & ~1u;
+
+	sTableEntry& a = table[slot];
+	sTableEntry& b = table[slot + 1];
+
+	if (a.key == key || a.key == -1)
+		return a;
+	if (b.key == key || b.key == -1)
+		return b;
+
+	if (a.iteration != iteration)
+		return a;
+	if (b.iteration != iteration)
+		return b;
+
+	return (a.g >= b.g) ? a : b;
+}
+
+void A_STAR::memoryBoundedSearch(const cPathGrid& grid, Pair src, Pair dest,
+	size_t memoryLimitBytes)
+{
+	layout = grid.GetLayout();
+
+	result = sSearchResult();
+	result.memoryLimitBytes = memoryLimitBytes;
+	path.clear();
+
+	searchSrc = src;
+	searchDest = dest;
+
+	// If the source or the destination is out of range
+	if (isValid(src.first, src.second) == false
+		|| isValid(dest.first, dest.second) == false) {
+		printf("Source or destination is invalid.\n");
+		return;
+	}
+
+	// Either the source or the destination is blocked
+	if (isUnBlocked(grid, src.first, src.second) == false
+		|| isUnBlocked(grid, dest.first, dest.second) == false) {
+		printf("Source or the destination is blocked.\n");
+		return;
+	}
+
+	// If the destination cell is the same as source cell
+	if (isDestination(src.first, src.second, dest) == true) {
+		printf("We are already at the destination.\n");
+		result.found = true;
+		path.push_back(glm::vec2(src.first, src.second));
+		return;
+	}
+
+	// Largest power of two table that fits in its share of the cap
+	size_t tableSize = 2;
+	while (tableSize * 2 * sizeof(sTableEntry) <= memoryLimitBytes * TABLE_SHARE) {
+		tableSize *= 2;
+	}
+
+	size_t tableBytes = tableSize * sizeof(sTableEntry);
+	size_t stackBudget = 0;
+	if (memoryLimitBytes > tableBytes) {
+		stackBudget = memoryLimitBytes - tableBytes;
+	}
+
+	// The stack, its successors, the best path and the successor lists
+	// of the cell being expanded are all allocated up front from what's
+	// left, and never grow. The lists and the best path's destination
+	// (which has no frame) come off the top.
+	size_t scratchBytes = SUCCESSORS_PER_FRAME * SUCCESSOR_BYTES + sizeof(Pair);
+	stackBudget = (stackBudget > scratchBytes) ? stackBudget - scratchBytes : 0;
+
+	size_t maxFrames = stackBudget / (FRAME_BYTES + SUCCESSORS_PER_FRAME * SUCCESSOR_BYTES);
+	size_t poolCapacity = (stackBudget - maxFrames * FRAME_BYTES) / SUCCESSOR_BYTES;
+
+	// Room for at least two cells with all 8 neighbours
+	if (maxFrames < 2) {
+		printf("Memory limit of %zu bytes is too small to search.\n", memoryLimitBytes);
+		result.hitMemoryLimit = true;
+		return;
+	}
+
+	unsigned int mask = (unsigned int)tableSize - 1;
+
+	sTableEntry empty = { -1, 0, DBL_MAX };
+	vector<sTableEntry> table(tableSize, empty);
+
+	vector<sSearchFrame> stack;
+	vector<Pair> successorPool;
+	vector<double> costPool;
+
+	stack.reserve(maxFrames);
+	successorPool.reserve(poolCapacity);
+	costPool.reserve(poolCapacity);
+
+	// Successors of the cell being expanded. 8 at most, only symmetry
+	// reduction can grow them past the cap (to a few dozen).
+	vector<Pair> successors;
+	vector<double> costs;
+
+	successors.reserve(SUCCESSORS_PER_FRAME);
+	costs.reserve(SUCCESSORS_PER_FRAME);
+
+	// Push a cell whose successors were just put in 'successors'
+	auto pushFrame = [&](Pair cell, double g) {
+		sSearchFrame frame;
+		frame.cell = cell;
+		frame.g = g;
+		frame.first = (int)successorPool.size();
+		frame.next = frame.first;
+		frame.count = (int)successors.size();
+
+		successorPool.insert(successorPool.end(), successors.begin(), successors.end());
+		costPool.insert(costPool.end(), costs.begin(), costs.end());
+		stack.push_back(frame);
+	};
+
+	// Whether a cell with 'count' successors still fits on the stack
+	auto fitsOnStack = [&](int count) {
+		return stack.size() < maxFrames && successorPool.size() + count <= poolCapacity;
+	};
+
+	double threshold = calculateHValue(src.first, src.second, dest);
+
+	// Best path found in the current iteration, the stack plus the destination
+	double bestCost = DBL_MAX;
+	vector<Pair> bestPath;
+	bestPath.reserve(maxFrames + 1);
+
+	while (true) {
+		result.iterations++;
+
+		double nextThreshold = DBL_MAX;
+
+		// Start every iteration from the source
+		int rootCount = getSearchSuccessors(grid, src.first, src.second, successors, costs);
+		if (!fitsOnStack(rootCount)) {
+			printf("Memory limit of %zu bytes is too small to search.\n", memoryLimitBytes);
+			result.hitMemoryLimit = true;
+			return;
+		}
+
+		pushFrame(src, 0.0);
+		result.nodesExpanded++;
+
+		int srcKey = layout.Index(src.first, src.second);
+		sTableEntry& srcEntry = probeTable(table, srcKey, mask, result.iterations);
+		srcEntry.key = srcKey;
+		srcEntry.iteration = result.iterations;
+		srcEntry.g = 0.0;
+
+		while (!stack.empty()) {
+			sSearchFrame& top = stack.back();
+
+			// Every successor has been tried, backtrack
+			if (top.next == top.first + top.count) {
+				successorPool.resize(top.first);
+				costPool.resize(top.first);
+				stack.pop_back();
+				continue;
+			}
+
+			Pair cell = successorPool[top.next];
+			double gNew = top.g + costPool[top.next];
+			top.next++;
+
+			double fNew = gNew + calculateHValue(cell.first, cell.second, dest);
+
+			// Too expensive for this iteration, but it could set the next threshold
+			if (fNew > threshold + 1e-9) {
+				if (fNew < nextThreshold)
+					nextThreshold = fNew;
+				continue;
+			}
+
+			if (isDestination(cell.first, cell.second, dest) == true) {
+				// Only look for strictly cheaper paths from now on
+				bestCost = gNew;
+				threshold = gNew - 1e-6;
+
+				bestPath.clear();
+				for (int k = 0; k < stack.size(); k++) {
+					bestPath.push_back(stack[k].cell);
+				}
+				bestPath.push_back(cell);
+				continue;
+			}
+
+			// Transposition check
+			int key = layout.Index(cell.first, cell.second);
+			sTableEntry& entry = probeTable(table, key, mask, result.iterations);
+
+			bool regenerated = entry.key == key;
+
+			// Already reached this iteration with a path at least as good
+			if (regenerated && entry.iteration == result.iterations && entry.g <= gNew)
+				continue;
+
+			int count = getSearchSuccessors(grid, cell.first, cell.second, successors, costs);
+
+			// Out of stack budget, can't go any deeper. The cell isn't
+			// recorded, it wasn't expanded and mustn't prune a later visit
+			if (!fitsOnStack(count)) {
+				result.hitMemoryLimit = true;
+				continue;
+			}
+
+			if (!regenerated && entry.key != -1)
+				result.tableEvictions++;
+
+			entry.key = key;
+			entry.iteration = result.iterations;
+			entry.g = gNew;
+
+			// Expand the cell
+			pushFrame(cell, gNew);
+
+			result.nodesExpanded++;
+			if (regenerated)
+				result.nodesRegenerated++;
+		}
+
+		// Everything is allocated up front, only the successor lists can
+		// have grown past what they started with (symmetry reduction)
+		result.peakMemoryBytes = table.capacity() * sizeof(sTableEntry)
+			+ stack.capacity() * sizeof(sSearchFrame) + bestPath.capacity() * sizeof(Pair)
+			+ successorPool.capacity() * sizeof(Pair) + costPool.capacity() * sizeof(double)
+			+ successors.capacity() * sizeof(Pair) + costs.capacity() * sizeof(double);
+
+		if (bestCost != DBL_MAX) {
+			if (verbose) {
+				printf("The destination cell is found.\n");
+				printf("\nThe Path is ");
+			}
+
+			for (int k = 0; k < bestPath.size(); k++) {
+				path.push_back(glm::vec2(bestPath[k].first, bestPath[k].second));
+				if (verbose)
+					printf("-> (%d,%d) ", bestPath[k].first, bestPath[k].second);
+			}
+
+			if (useSymmetryReduction())
+				expandMacroEdges();
+
+			result.found = true;
+			result.pathCost = bestCost;
+
+			if (verbose)
+				printf("\nIterations: %u, expanded: %u, regenerated: %u, evictions: %u, peak memory: %zu / %zu bytes\n",
+					result.iterations, result.nodesExpanded, result.nodesRegenerated,
+					result.tableEvictions, result.peakMemoryBytes, result.memoryLimitBytes);
+			return;
+		}
+
+		// Nothing was cut off, every reachable cell has been seen
+		if (nextThreshold == DBL_MAX)
+			break;
+
+		if (nextThreshold < threshold + THRESHOLD_STEP)
+			nextThreshold = threshold + THRESHOLD_STEP;
+
+		threshold = nextThreshold;
+	}
+
+	printf("Failed to find the Destination Cell.\n");
+	if (result.hitMemoryLimit)
+		printf("The search stack ran out of its share of the %zu byte memory limit.\n", memoryLimitBytes);
+}
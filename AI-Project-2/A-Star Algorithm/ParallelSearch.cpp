@@ -0,0 +1,317 @@
+#include "A-Star.h"
+
+#include <atomic>
+#include <thread>
+#include <queue>
+#include <functional>
+#include <cfloat>
+#include <cmath>
+
+// Hash-distributed parallel A* (HDA*)
+//
+// Every cell is owned by exactly one worker thread, picked by hashing the
+// cell. A worker keeps its own open list and is the only one that ever
+// writes the 'g'/parent of the cells it owns, so the per-cell data needs
+// no locks. Successors owned by other workers are batched up and pushed
+// onto the owner's inbox, a lock-free stack of batches that the owner
+// takes in one atomic exchange.
+//
+// Termination uses a single counter of outstanding work: +1 for every
+// busy worker and +1 for every message that was sent but not yet
+// received. A worker is idle when its open list holds nothing that could
+// still beat the best path found so far (the incumbent). When the counter
+// drops to zero nobody can create more work, and the incumbent is optimal.
+
+// Successor handed over to the worker that owns it
+struct sParallelMessage {
+	int key;			// layout.Index(row, col)
+	int parentKey;
+	double g;
+};
+
+// Batch of messages, linked into the receiver's inbox
+struct sMessageBatch {
+	vector<sParallelMessage> messages;
+	sMessageBatch* next;
+};
+
+// Send a batch once it holds this many messages, or when going idle
+static const int MESSAGE_BATCH_SIZE = 64;
+
+// Also flush partial batches every so many expansions to keep others busy
+static const int FLUSH_INTERVAL = 256;
+
+static int ownerOfCell(int key, int numThreads)
+{
+	return (int)((((unsigned int)key * 2654435761u) >> 16) % (unsigned int)numThreads);
+}
+
+void A_STAR::parallelSearch(const cPathGrid& grid, Pair src, Pair dest, int numThreads)
+{
+	layout = grid.GetLayout();
+
+	result = sSearchResult();
+	path.clear();
+
+	searchSrc = src;
+	searchDest = dest;
+
+	// If the source or the destination is out of range
+	if (isValid(src.first, src.second) == false
+		|| isValid(dest.first, dest.second) == false) {
+		printf("Source or destination is invalid.\n");
+		return;
+	}
+
+	// Either the source or the destination is blocked
+	if (isUnBlocked(grid, src.first, src.second) == false
+		|| isUnBlocked(grid, dest.first, dest.second) == false) {
+		printf("Source or the destination is blocked.\n");
+		return;
+	}
+
+	// If the destination cell is the same as source cell
+	if (isDestination(src.first, src.second, dest) == true) {
+		printf("We are already at the destination.\n");
+		result.found = true;
+		path.push_back(glm::vec2(src.first, src.second));
+		return;
+	}
+
+	if (numThreads < 1) {
+		numThreads = (int)thread::hardware_concurrency();
+		if (numThreads < 1)
+			numThreads = 1;
+	}
+
+	result.threadsUsed = numThreads;
+
+	// Per cell data, each entry only ever written by its owner
+	vector<double> gValue(layout.Size(), DBL_MAX);
+	vector<int> parentKey(layout.Size(), -1);
+
+	// Per worker data
+	vector< atomic<sMessageBatch*> > inbox(numThreads);
+	vector<unsigned int> expanded(numThreads, 0);
+	vector<unsigned int> sent(numThreads, 0);
+
+	for (int t = 0; t < numThreads; t++) {
+		inbox[t].store(nullptr);
+	}
+
+	atomic<double> incumbent(DBL_MAX);
+	atomic<long long> outstandingWork(0);
+
+	int srcKey = layout.Index(src.first, src.second);
+	int destKey = layout.Index(dest.first, dest.second);
+
+	// Seed the search by "sending" the source to its owner
+	{
+		sMessageBatch* seed = new sMessageBatch();
+		seed->messages.push_back({ srcKey, srcKey, 0.0 });
+		seed->next = nullptr;
+		outstandingWork += 1;
+		inbox[ownerOfCell(srcKey, numThreads)].store(seed);
+	}
+
+	auto worker = [&](int self) {
+		// <f, <g, key>>
+		typedef pair<double, pair<double, int> > openEntry;
+		priority_queue<openEntry, vector<openEntry>, greater<openEntry> > openList;
+
+		vector< vector<sParallelMessage> > outbox(numThreads);
+		for (int t = 0; t < numThreads; t++) {
+			outbox[t].reserve(MESSAGE_BATCH_SIZE);
+		}
+
+		bool idle = true;
+		int sinceFlush = 0;
+
+		vector<Pair> successors;
+		vector<double> costs;
+
+		// Take a message, keep it if it's the best way to the cell so far
+		auto receive = [&](const sParallelMessage& m) {
+			if (m.g >= gValue[m.key])
+				return;
+
+			gValue[m.key] = m.g;
+			parentKey[m.key] = m.parentKey;
+
+			if (m.key == destKey) {
+				// New incumbent
+				double best = incumbent.load();
+				while (m.g < best && !incumbent.compare_exchange_weak(best, m.g)) {}
+				return;
+			}
+
+			Pair cell = layout.Coordinates(m.key);
+			double f = m.g + calculateHValue(cell.first, cell.second, dest);
+			if (f < incumbent.load())
+				openList.push(make_pair(f, make_pair(m.g, m.key)));
+		};
+
+		auto flush = [&](int to) {
+			if (outbox[to].empty())
+				return;
+
+			sMessageBatch* batch = new sMessageBatch();
+			batch->messages.swap(outbox[to]);
+			outbox[to].reserve(MESSAGE_BATCH_SIZE);
+
+			// Counted before the push, while this worker is still busy
+			outstandingWork += (long long)batch->messages.size();
+			sent[self] += (unsigned int)batch->messages.size();
+
+			batch->next = inbox[to].load(memory_order_relaxed);
+			while (!inbox[to].compare_exchange_weak(batch->next, batch,
+				memory_order_release, memory_order_relaxed)) {}
+		};
+
+		while (true) {
+			//----------- Drain the inbox ------------
+			sMessageBatch* batch = inbox[self].exchange(nullptr, memory_order_acquire);
+
+			if (batch != nullptr && idle) {
+				idle = false;
+				outstandingWork += 1;
+			}
+
+			while (batch != nullptr) {
+				for (int k = 0; k < batch->messages.size(); k++) {
+					receive(batch->messages[k]);
+				}
+				outstandingWork -= (long long)batch->messages.size();
+
+				sMessageBatch* next = batch->next;
+				delete batch;
+				batch = next;
+			}
+
+			// Drop entries that are stale or can't beat the incumbent
+			while (!openList.empty()) {
+				const openEntry& top = openList.top();
+				if (top.second.first > gValue[top.second.second]
+					|| top.first >= incumbent.load()) {
+					openList.pop();
+				}
+				else {
+					break;
+				}
+			}
+
+			//----------- Nothing to do, go idle ------------
+			if (openList.empty()) {
+				if (!idle) {
+					for (int t = 0; t < numThreads; t++) {
+						flush(t);
+					}
+					idle = true;
+					outstandingWork -= 1;
+				}
+
+				if (outstandingWork.load() == 0)
+					break;
+
+				this_thread::yield();
+				continue;
+			}
+
+			//----------- Expand the best cell ------------
+			openEntry p = openList.top();
+			openList.pop();
+
+			int key = p.second.second;
+			double g = p.second.first;
+			Pair cell = layout.Coordinates(key);
+			int i = cell.first;
+			int j = cell.second;
+
+			expanded[self]++;
+
+			int count = getSearchSuccessors(grid, i, j, successors, costs);
+
+			for (int k = 0; k < count; k++) {
+				int succKey = layout.Index(successors[k].first, successors[k].second);
+				double gNew = g + costs[k];
+
+				if (gNew + calculateHValue(successors[k].first, successors[k].second, dest)
+					>= incumbent.load())
+					continue;
+
+				sParallelMessage m = { succKey, key, gNew };
+				int owner = ownerOfCell(succKey, numThreads);
+
+				if (owner == self) {
+					receive(m);
+				}
+				else {
+					outbox[owner].push_back(m);
+					if (outbox[owner].size() >= MESSAGE_BATCH_SIZE)
+						flush(owner);
+				}
+			}
+
+			if (++sinceFlush >= FLUSH_INTERVAL) {
+				for (int t = 0; t < numThreads; t++) {
+					flush(t);
+				}
+				sinceFlush = 0;
+			}
+		}
+	};
+
+	vector<thread> workers;
+	for (int t = 0; t < numThreads; t++) {
+		workers.push_back(thread(worker, t));
+	}
+	for (int t = 0; t < numThreads; t++) {
+		workers[t].join();
+	}
+
+	for (int t = 0; t < numThreads; t++) {
+		result.nodesExpanded += expanded[t];
+		result.messagesSent += sent[t];
+	}
+	result.iterations = 1;
+
+	if (incumbent.load() == DBL_MAX) {
+		printf("Failed to find the Destination Cell.\n");
+		return;
+	}
+
+	result.found = true;
+	result.pathCost = incumbent.load();
+
+	// Parents only ever point at cells with a smaller 'g',
+	// so following them always ends up back at the source
+	stack<Pair> Path;
+	int key = destKey;
+	while (key != srcKey) {
+		Path.push(layout.Coordinates(key));
+		key = parentKey[key];
+	}
+	Path.push(src);
+
+	if (verbose) {
+		printf("The destination cell is found.\n");
+		printf("\nThe Path is ");
+	}
+
+	while (!Path.empty()) {
+		Pair p = Path.top();
+		Path.pop();
+
+		path.push_back(glm::vec2(p.first, p.second));
+
+		if (verbose)
+			printf("-> (%d,%d) ", p.first, p.second);
+	}
+
+	if (useSymmetryReduction())
+		expandMacroEdges();
+
+	if (verbose)
+		printf("\nThreads: %d, expanded: %u, messages: %u\n",
+			result.threadsUsed, result.nodesExpanded, result.messagesSent);
+}
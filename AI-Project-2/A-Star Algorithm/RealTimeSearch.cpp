@@ -0,0 +1,235 @@
+#include "A-Star.h"
+
+#include <queue>
+#include <functional>
+#include <cstring>
+#include <cfloat>
+#include <cmath>
+
+// Real-time search (LSS-LRTA*)
+//
+// Each tick runs a bounded A* around the agent, updates the learned
+// heuristic of every cell it expanded with a Dijkstra style backup from
+// the lookahead frontier, then moves the agent one cell towards the most
+// promising frontier cell. Learned values make the agent's estimates
+// more informed every time it revisits an area, so it can't get stuck
+// in a dead end forever.
+
+// A Utility Function to read the learned (LRTA*) heuristic of a
+// cell, seeding it with the straight line distance on first use.
+double A_STAR::getLearnedHValue(int row, int col)
+{
+	int index = layout.Index(row, col);
+
+	if (learnedEpoch[index] != rtEpoch) {
+		learnedH[index] = calculateHValue(row, col, rtDest);
+		learnedEpoch[index] = rtEpoch;
+	}
+	return learnedH[index];
+}
+
+void A_STAR::InitRealTimeSearch(const cPathGrid& grid, Pair src, Pair dest)
+{
+	bool sameGrid = learnedH.size() == grid.GetLayout().Size()
+		&& layout.Rows() == grid.Rows() && layout.Cols() == grid.Cols()
+		&& layout.Layout() == grid.GetLayout().Layout();
+
+	layout = grid.GetLayout();
+
+	// Learned values only hold for a single destination on a single map
+	if (dest != rtDest || !sameGrid) {
+		learnedH.assign(layout.Size(), 0.0);
+		learnedEpoch.assign(layout.Size(), 0);
+		rtEpoch = 1;
+
+		rtG.assign(layout.Size(), 0.0);
+		rtParent.assign(layout.Size(), make_pair(-1, -1));
+		rtClosed.assign(layout.Size(), false);
+	}
+
+	rtStamp.assign(layout.Size(), 0);
+	rtTick = 0;
+
+	rtCurrent = src;
+	rtDest = dest;
+
+	// RealTimeStep doesn't move the agent until both are good
+	if (isValid(src.first, src.second) == false
+		|| isValid(dest.first, dest.second) == false) {
+		printf("Source or the destination is invalid.\n");
+	}
+	else if (isUnBlocked(grid, src.first, src.second) == false) {
+		printf("Source is blocked.\n");
+	}
+}
+
+bool A_STAR::RealTimeStep(const cPathGrid& grid, int lookahead, Pair& nextCell)
+{
+	nextCell = rtCurrent;
+
+	if (isDestination(rtCurrent.first, rtCurrent.second, rtDest) == true)
+		return false;
+
+	// Started off the map, or on a wall
+	if (isValid(rtCurrent.first, rtCurrent.second) == false
+		|| isValid(rtDest.first, rtDest.second) == false
+		|| isUnBlocked(grid, rtCurrent.first, rtCurrent.second) == false)
+		return false;
+
+	if (lookahead < 1)
+		lookahead = 1;
+
+	// New stamp for this tick's scratch data
+	rtTick++;
+	if (rtTick == 0) {
+		rtStamp.assign(layout.Size(), 0);
+		rtTick = 1;
+	}
+
+	Pair successors[8];
+	double costs[8];
+
+	int i = rtCurrent.first;
+	int j = rtCurrent.second;
+	int index = layout.Index(i, j);
+
+	rtStamp[index] = rtTick;
+	rtG[index] = 0.0;
+	rtParent[index] = rtCurrent;
+	rtClosed[index] = false;
+
+	// <f, <i, j>> just like the full search
+	set<pPair> openList;
+	openList.insert(make_pair(getLearnedHValue(i, j), rtCurrent));
+
+	vector<Pair> closedCells;
+	closedCells.reserve(lookahead);
+
+	//----------- Bounded lookahead ------------
+	while (!openList.empty() && (int)closedCells.size() < lookahead) {
+		pPair p = *openList.begin();
+
+		i = p.second.first;
+		j = p.second.second;
+		index = layout.Index(i, j);
+
+		// Stop as soon as the destination is the best candidate,
+		// it stays on the open list as the move target
+		if (isDestination(i, j, rtDest) == true)
+			break;
+
+		openList.erase(openList.begin());
+		rtClosed[index] = true;
+		closedCells.push_back(p.second);
+
+		int count = getSuccessors(grid, i, j, successors, costs);
+
+		for (int k = 0; k < count; k++) {
+			int r = successors[k].first;
+			int c = successors[k].second;
+			int succIndex = layout.Index(r, c);
+
+			if (rtStamp[succIndex] != rtTick) {
+				rtStamp[succIndex] = rtTick;
+				rtG[succIndex] = DBL_MAX;
+				rtClosed[succIndex] = false;
+			}
+
+			if (rtClosed[succIndex] == true)
+				continue;
+
+			double gNew = rtG[index] + costs[k];
+
+			if (gNew < rtG[succIndex]) {
+				double h = getLearnedHValue(r, c);
+
+				// Drop the old open list entry before re-inserting
+				if (rtG[succIndex] != DBL_MAX)
+					openList.erase(make_pair(rtG[succIndex] + h, successors[k]));
+
+				rtG[succIndex] = gNew;
+				rtParent[succIndex] = make_pair(i, j);
+				openList.insert(make_pair(gNew + h, successors[k]));
+			}
+		}
+	}
+
+	// Nothing left on the frontier, the destination can't be reached
+	if (openList.empty())
+		return false;
+
+	// The most promising frontier cell, where we are heading
+	Pair target = openList.begin()->second;
+
+	//----------- Learning (Dijkstra backup) ------------
+	if (!closedCells.empty()) {
+		for (int k = 0; k < closedCells.size(); k++) {
+			learnedH[layout.Index(closedCells[k].first, closedCells[k].second)] = DBL_MAX;
+		}
+
+		priority_queue<pPair, vector<pPair>, greater<pPair> > backup;
+
+		for (set<pPair>::iterator it = openList.begin(); it != openList.end(); it++) {
+			Pair s = it->second;
+			backup.push(make_pair(getLearnedHValue(s.first, s.second), s));
+		}
+
+		while (!backup.empty()) {
+			pPair p = backup.top();
+			backup.pop();
+
+			i = p.second.first;
+			j = p.second.second;
+			index = layout.Index(i, j);
+
+			// Stale entry
+			if (p.first != learnedH[index])
+				continue;
+
+			// The value of this cell is now final
+			rtClosed[index] = false;
+
+			int count = getSuccessors(grid, i, j, successors, costs);
+
+			for (int k = 0; k < count; k++) {
+				int succIndex = layout.Index(successors[k].first, successors[k].second);
+
+				if (rtStamp[succIndex] != rtTick || rtClosed[succIndex] == false)
+					continue;
+
+				double hNew = costs[k] + learnedH[index];
+
+				if (hNew < learnedH[succIndex]) {
+					learnedH[succIndex] = hNew;
+					backup.push(make_pair(hNew, successors[k]));
+				}
+			}
+		}
+	}
+
+	//----------- Commit a single move ------------
+	Pair step = target;
+	while (rtParent[layout.Index(step.first, step.second)] != rtCurrent) {
+		step = rtParent[layout.Index(step.first, step.second)];
+	}
+
+	rtCurrent = step;
+	nextCell = step;
+
+	return true;
+}
+
+Pair A_STAR::GetRealTimePosition()
+{
+	return rtCurrent;
+}
+
+void A_STAR::ForgetLearnedHeuristic()
+{
+	// A new epoch, every entry is older than it now
+	rtEpoch++;
+	if (rtEpoch == 0) {
+		learnedEpoch.assign(learnedEpoch.size(), 0);
+		rtEpoch = 1;
+	}
+}
@@ -0,0 +1,237 @@
+#include "cChunkedMap.h"
+
+#include <cstring>
+
+static const char FILE_MAGIC[4] = { 'T', 'I', 'L', 'E' };
+static const size_t HEADER_SIZE = 20;
+
+// The most tiles a cell and its 8 neighbours can touch
+static const size_t MIN_RESIDENT_TILES = 4;
+
+static unsigned int readU32(const unsigned char* p)
+{
+	return (unsigned int)p[0] | ((unsigned int)p[1] << 8)
+		| ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+static void writeU32(std::ofstream& out, unsigned int value)
+{
+	unsigned char bytes[4];
+	for (int k = 0; k < 4; k++) {
+		bytes[k] = (unsigned char)(value >> (8 * k));
+	}
+	out.write((const char*)bytes, 4);
+}
+
+cChunkedMap::cChunkedMap()
+	: rows(0)
+	, cols(0)
+	, tileRows(0)
+	, tileCols(0)
+	, maxTiles(MIN_RESIDENT_TILES)
+	, lastKey(-1)
+	, lastBits(nullptr)
+{
+}
+
+cChunkedMap::~cChunkedMap() {
+
+	Close();
+}
+
+std::string cChunkedMap::getLastError(void) {
+
+	return lastError;
+}
+
+bool cChunkedMap::Create(const std::string& fileName, int rows, int cols,
+	const std::function<bool(int row, int col)>& isWalkable) {
+
+	if (rows <= 0 || cols <= 0)
+		return false;
+
+	std::ofstream out(fileName.c_str(), std::ios::binary);
+	if (!out.is_open())
+		return false;
+
+	out.write(FILE_MAGIC, 4);
+	writeU32(out, VERSION);
+	writeU32(out, (unsigned int)rows);
+	writeU32(out, (unsigned int)cols);
+	writeU32(out, (unsigned int)TILE_SIZE);
+
+	int tileRows = (rows + TILE_SIZE - 1) >> TILE_SHIFT;
+	int tileCols = (cols + TILE_SIZE - 1) >> TILE_SHIFT;
+
+	std::vector<unsigned char> bits(TILE_BYTES);
+
+	for (int tr = 0; tr < tileRows; tr++) {
+		for (int tc = 0; tc < tileCols; tc++) {
+			std::fill(bits.begin(), bits.end(), 0);
+
+			for (int r = 0; r < TILE_SIZE; r++) {
+				int row = (tr << TILE_SHIFT) + r;
+				if (row >= rows)
+					break;
+
+				for (int c = 0; c < TILE_SIZE; c++) {
+					int col = (tc << TILE_SHIFT) + c;
+					if (col >= cols)
+						break;
+
+					if (isWalkable(row, col)) {
+						int inTile = (r << TILE_SHIFT) | c;
+						bits[inTile >> 3] |= (unsigned char)(1 << (inTile & 7));
+					}
+				}
+			}
+
+			out.write((const char*)bits.data(), TILE_BYTES);
+		}
+	}
+
+	return out.good();
+}
+
+bool cChunkedMap::Create(const std::string& fileName, const cPathGrid& grid) {
+
+	return Create(fileName, grid.Rows(), grid.Cols(),
+		[&grid](int row, int col) { return grid.IsWalkable(row, col); });
+}
+
+bool cChunkedMap::Open(const std::string& fileName, size_t budgetBytes) {
+
+	Close();
+	lastError = "";
+
+	file.open(fileName.c_str(), std::ios::binary);
+	if (!file.is_open()) {
+		lastError = "Could not open " + fileName;
+		return false;
+	}
+
+	unsigned char header[HEADER_SIZE];
+	file.read((char*)header, HEADER_SIZE);
+
+	if (!file || memcmp(header, FILE_MAGIC, 4) != 0) {
+		lastError = fileName + " is not a tile file";
+		Close();
+		return false;
+	}
+
+	if (readU32(header + 4) != VERSION || readU32(header + 16) != (unsigned int)TILE_SIZE) {
+		lastError = fileName + " was written by another version";
+		Close();
+		return false;
+	}
+
+	rows = (int)readU32(header + 8);
+	cols = (int)readU32(header + 12);
+
+	if (rows <= 0 || cols <= 0) {
+		lastError = fileName + " has no cells";
+		Close();
+		return false;
+	}
+
+	tileRows = (rows + TILE_SIZE - 1) >> TILE_SHIFT;
+	tileCols = (cols + TILE_SIZE - 1) >> TILE_SHIFT;
+
+	// Every tile has to be there
+	file.seekg(0, std::ios::end);
+	unsigned long long expected = HEADER_SIZE + (unsigned long long)tileRows * tileCols * TILE_BYTES;
+	if ((unsigned long long)file.tellg() < expected) {
+		lastError = fileName + " is truncated";
+		Close();
+		return false;
+	}
+
+	maxTiles = budgetBytes / TILE_BYTES;
+	if (maxTiles < MIN_RESIDENT_TILES)
+		maxTiles = MIN_RESIDENT_TILES;
+
+	tiles.reserve(maxTiles);
+
+	return true;
+}
+
+void cChunkedMap::Close() {
+
+	if (file.is_open())
+		file.close();
+	file.clear();
+
+	tiles.clear();
+	lru.clear();
+
+	lastKey = -1;
+	lastBits = nullptr;
+
+	rows = cols = 0;
+	tileRows = tileCols = 0;
+
+	stats = sChunkStats();
+}
+
+void cChunkedMap::ResetStats() {
+
+	stats.tileFaults = 0;
+	stats.tileHits = 0;
+	stats.evictions = 0;
+	stats.peakResidentBytes = stats.residentBytes;
+}
+
+const unsigned char* cChunkedMap::requestTile(int key) {
+
+	std::unordered_map<int, sTile>::iterator it = tiles.find(key);
+
+	if (it != tiles.end()) {
+		stats.tileHits++;
+
+		// Most recently used now
+		lru.splice(lru.begin(), lru, it->second.lru);
+		lastBits = it->second.bits.data();
+	}
+	else {
+		stats.tileFaults++;
+
+		// Reuse the buffer of the least recently used tile
+		std::vector<unsigned char> bits;
+		if (tiles.size() >= maxTiles) {
+			std::unordered_map<int, sTile>::iterator oldest = tiles.find(lru.back());
+			bits.swap(oldest->second.bits);
+			tiles.erase(oldest);
+			lru.pop_back();
+
+			stats.evictions++;
+		}
+		else {
+			bits.resize(TILE_BYTES);
+		}
+
+		unsigned long long offset = HEADER_SIZE + (unsigned long long)key * TILE_BYTES;
+		file.seekg((std::streamoff)offset, std::ios::beg);
+		file.read((char*)bits.data(), TILE_BYTES);
+
+		// A read error reads as all walls rather than garbage
+		if (!file) {
+			file.clear();
+			std::fill(bits.begin(), bits.end(), 0);
+		}
+
+		lru.push_front(key);
+
+		sTile& tile = tiles[key];
+		tile.bits.swap(bits);
+		tile.lru = lru.begin();
+		lastBits = tile.bits.data();
+
+		stats.residentTiles = tiles.size();
+		stats.residentBytes = tiles.size() * TILE_BYTES;
+		if (stats.residentBytes > stats.peakResidentBytes)
+			stats.peakResidentBytes = stats.residentBytes;
+	}
+
+	lastKey = key;
+	return lastBits;
+}
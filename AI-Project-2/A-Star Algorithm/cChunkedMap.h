@@ -0,0 +1,129 @@
+#pragma once
+
+// Walkability of a world too big to keep in memory.
+//
+// The map is cut into TILE_SIZE x TILE_SIZE tiles stored one after the
+// other in a tile file on disk, 1 bit per cell. Tiles are only read when
+// a cell in them is asked for, and at most 'budgetBytes' worth of them
+// stay resident: the least recently used tile is dropped to make room
+// for the next one. A 65536 x 65536 world is 512 MB on disk, while the
+// search only keeps the tiles around its frontier.
+//
+// Tile file, values little endian:
+//     0   "TILE"
+//     4   u32 version, u32 rows, u32 cols, u32 tile size
+//     20  tiles in row-major tile order, TILE_BYTES each. Cells outside
+//         the map in the last row/column of tiles are blocked.
+
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <fstream>
+#include <functional>
+
+#include "cPathGrid.h"
+
+// Paging statistics since the map was opened (or ResetStats)
+struct sChunkStats {
+	// Tile lookups that had to read the tile from disk
+	unsigned long long tileFaults = 0;
+	// Tile lookups served by a resident tile
+	unsigned long long tileHits = 0;
+	// Tiles dropped to stay within the budget
+	unsigned long long evictions = 0;
+
+	size_t residentTiles = 0;
+	size_t residentBytes = 0;
+	size_t peakResidentBytes = 0;
+};
+
+class cChunkedMap {
+public:
+	static const unsigned int VERSION = 1;
+
+	static const int TILE_SHIFT = 8;
+	static const int TILE_SIZE = 1 << TILE_SHIFT;
+	static const size_t TILE_BYTES = TILE_SIZE * TILE_SIZE / 8;
+
+	cChunkedMap();
+	~cChunkedMap();
+
+	// Writes a tile file, one tile at a time, so the world never has to
+	// be in memory as a whole
+	static bool Create(const std::string& fileName, int rows, int cols,
+		const std::function<bool(int row, int col)>& isWalkable);
+
+	// Same, from a grid that fits in memory
+	static bool Create(const std::string& fileName, const cPathGrid& grid);
+
+	// Nothing is read yet besides the header. The budget is rounded
+	// down to whole tiles, and never goes below the 4 tiles a cell and
+	// its neighbours can touch.
+	bool Open(const std::string& fileName, size_t budgetBytes);
+	void Close();
+
+	bool IsOpen() const { return file.is_open(); }
+
+	int Rows() const { return rows; }
+	int Cols() const { return cols; }
+
+	bool IsInside(int row, int col) const
+	{
+		return (row >= 0) && (row < rows) && (col >= 0) && (col < cols);
+	}
+
+	// Pages the tile holding the cell in if needed
+	bool IsWalkable(int row, int col)
+	{
+		int key = tileKey(row >> TILE_SHIFT, col >> TILE_SHIFT);
+
+		// Neighbouring cells nearly always share a tile
+		const unsigned char* bits = (key == lastKey) ? lastBits : requestTile(key);
+
+		int inTile = ((row & (TILE_SIZE - 1)) << TILE_SHIFT) | (col & (TILE_SIZE - 1));
+		return ((bits[inTile >> 3] >> (inTile & 7)) & 1) != 0;
+	}
+
+	// Makes sure a tile is resident, e.g. ahead of a search frontier
+	void RequestTile(int tileRow, int tileCol) { requestTile(tileKey(tileRow, tileCol)); }
+
+	int TileRows() const { return tileRows; }
+	int TileCols() const { return tileCols; }
+
+	size_t BudgetBytes() const { return maxTiles * TILE_BYTES; }
+
+	const sChunkStats& GetStats() const { return stats; }
+	void ResetStats();
+
+	std::string getLastError(void);
+
+private:
+	struct sTile {
+		std::vector<unsigned char> bits;
+		std::list<int>::iterator lru;
+	};
+
+	int tileKey(int tileRow, int tileCol) const { return tileRow * tileCols + tileCol; }
+
+	// Resident tile data, read from disk on a fault
+	const unsigned char* requestTile(int key);
+
+	std::ifstream file;
+	int rows;
+	int cols;
+	int tileRows;
+	int tileCols;
+	size_t maxTiles;
+
+	std::unordered_map<int, sTile> tiles;
+	// Most recently used tile first
+	std::list<int> lru;
+
+	// Last tile looked up, skips the hash map and LRU update
+	int lastKey;
+	const unsigned char* lastBits;
+
+	sChunkStats stats;
+	std::string lastError;
+};
@@ -0,0 +1,134 @@
+#include "cCompactPath.h"
+
+// Row/column offset of every direction code
+static const int dRow[8] = { -1, 1, 0, 0, -1, -1, 1, 1 };
+static const int dCol[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+
+cCompactPath::cCompactPath() {
+
+	Clear();
+}
+
+cCompactPath::~cCompactPath() {
+
+}
+
+void cCompactPath::Clear() {
+
+	start = std::make_pair(-1, -1);
+	last = start;
+	steps = 0;
+	hasStart = false;
+	bits.clear();
+}
+
+void cCompactPath::SetStart(Pair start) {
+
+	Clear();
+
+	this->start = start;
+	last = start;
+	hasStart = true;
+}
+
+bool cCompactPath::Append(Pair next) {
+
+	if (!hasStart) {
+		SetStart(next);
+		return true;
+	}
+
+	for (int k = 0; k < 8; k++) {
+		if (last.first + dRow[k] == next.first && last.second + dCol[k] == next.second) {
+			AppendDirection((eDirection)k);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void cCompactPath::AppendDirection(eDirection direction) {
+
+	int bit = steps * BITS_PER_STEP;
+	int byte = bit >> 3;
+	int shift = bit & 7;
+
+	// A code can straddle two bytes
+	if (bits.size() < (size_t)((bit + BITS_PER_STEP + 7) >> 3))
+		bits.resize((bit + BITS_PER_STEP + 7) >> 3, 0);
+
+	bits[byte] |= (unsigned char)(direction << shift);
+	if (shift > 8 - BITS_PER_STEP)
+		bits[byte + 1] |= (unsigned char)(direction >> (8 - shift));
+
+	last.first += dRow[direction];
+	last.second += dCol[direction];
+	steps++;
+}
+
+cCompactPath::eDirection cCompactPath::Direction(int step) const {
+
+	int bit = step * BITS_PER_STEP;
+	int byte = bit >> 3;
+	int shift = bit & 7;
+
+	unsigned int window = bits[byte];
+	if (byte + 1 < bits.size())
+		window |= (unsigned int)bits[byte + 1] << 8;
+
+	return (eDirection)((window >> shift) & 7);
+}
+
+bool cCompactPath::Encode(const std::vector<glm::vec2>& path) {
+
+	Clear();
+
+	for (int k = 0; k < path.size(); k++) {
+		if (!Append(std::make_pair((int)path[k].x, (int)path[k].y))) {
+			Clear();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void cCompactPath::Decode(std::vector<glm::vec2>& path) const {
+
+	path.clear();
+
+	for (Iterator it = begin(); it != end(); ++it) {
+		path.push_back(glm::vec2((*it).first, (*it).second));
+	}
+}
+
+cCompactPath::Iterator cCompactPath::begin() const {
+
+	Iterator it;
+	it.path = this;
+	it.step = 0;
+	it.cell = start;
+	return it;
+}
+
+cCompactPath::Iterator cCompactPath::end() const {
+
+	Iterator it;
+	it.path = this;
+	it.step = Length();
+	it.cell = last;
+	return it;
+}
+
+cCompactPath::Iterator& cCompactPath::Iterator::operator++() {
+
+	if (step < path->steps) {
+		eDirection direction = path->Direction(step);
+		cell.first += dRow[direction];
+		cell.second += dCol[direction];
+	}
+
+	step++;
+	return *this;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+// A grid path stored as its start cell plus one 3 bit direction code per
+// step, packed back to back. A step costs 3 bits instead of the 64 of a
+// glm::vec2, so thousands of cached or in-flight paths stay small.
+// Cells are decoded on the fly while iterating.
+
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+#include "cPathGrid.h"
+
+class cCompactPath {
+public:
+	// Same order as the successors of A_STAR
+	enum eDirection
+	{
+		NORTH,
+		SOUTH,
+		EAST,
+		WEST,
+		NORTH_EAST,
+		NORTH_WEST,
+		SOUTH_EAST,
+		SOUTH_WEST
+	};
+
+	// Walks the cells of the path, from the start cell to the last one
+	class Iterator {
+	public:
+		Iterator() : path(nullptr), step(0), cell(-1, -1) {}
+
+		Pair operator*() const { return cell; }
+
+		Iterator& operator++();
+
+		bool operator==(const Iterator& other) const
+		{
+			return path == other.path && step == other.step;
+		}
+
+		bool operator!=(const Iterator& other) const
+		{
+			return !(*this == other);
+		}
+
+	private:
+		friend class cCompactPath;
+
+		const cCompactPath* path;
+		int step;				// index of the current cell, Length() at the end
+		Pair cell;
+	};
+
+	cCompactPath();
+	~cCompactPath();
+
+	void Clear();
+
+	// Starts a new path at 'start'
+	void SetStart(Pair start);
+
+	// Adds a step to one of the 8 neighbours of the last cell.
+	// Returns false if 'next' isn't a neighbour.
+	bool Append(Pair next);
+
+	void AppendDirection(eDirection direction);
+
+	// Path as returned by A_STAR::GetPath()
+	bool Encode(const std::vector<glm::vec2>& path);
+	void Decode(std::vector<glm::vec2>& path) const;
+
+	Pair Start() const { return start; }
+	Pair End() const { return last; }
+
+	// Number of cells, start cell included (0 for an empty path)
+	int Length() const { return hasStart ? steps + 1 : 0; }
+	bool Empty() const { return !hasStart; }
+
+	eDirection Direction(int step) const;
+
+	Iterator begin() const;
+	Iterator end() const;
+
+	// Bytes used by the packed direction codes
+	size_t PackedBytes() const { return bits.size(); }
+
+private:
+	static const int BITS_PER_STEP = 3;
+
+	Pair start;
+	Pair last;
+	int steps;
+	bool hasStart;
+	std::vector<unsigned char> bits;
+};
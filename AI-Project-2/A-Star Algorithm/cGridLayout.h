@@ -0,0 +1,135 @@
+#pragma once
+
+// Maps (row, col) grid coordinates to a flat array index.
+//
+// Row-major is the plain row * cols + col. Moving north or south jumps a
+// whole row, so on wide maps every vertical neighbour lands on another
+// cache line. The tiled layout stores the map as 8x8 blocks of cells
+// that sit next to each other in memory, and the Morton (Z-order) layout
+// interleaves the bits of row and col, so cells that are close on the map
+// are close in memory in both directions.
+//
+// Every array that holds one entry per cell (walkability, g, parents,
+// closed flags ...) should be sized with Size() and indexed with Index().
+
+#include <cstddef>
+#include <utility>
+
+enum eGridLayout
+{
+	ROW_MAJOR_LAYOUT,
+	TILED_LAYOUT,		// 8x8 tiles, tiles in row-major order
+	MORTON_LAYOUT		// Z-order curve over a power of two square
+};
+
+class cGridLayout {
+public:
+	cGridLayout()
+		: layout(ROW_MAJOR_LAYOUT), rows(0), cols(0), tilesPerRow(0), size(0)
+	{
+	}
+
+	cGridLayout(int rows, int cols, eGridLayout layout)
+		: layout(layout), rows(rows), cols(cols)
+	{
+		// Whole tiles only, the padding cells are never used
+		tilesPerRow = (cols + TILE_SIZE - 1) >> TILE_SHIFT;
+		int tileRows = (rows + TILE_SIZE - 1) >> TILE_SHIFT;
+
+		// Smallest power of two square that holds the map
+		int side = 1;
+		while (side < rows || side < cols) {
+			side <<= 1;
+		}
+
+		switch (layout)
+		{
+			case TILED_LAYOUT:
+				size = (size_t)tileRows * tilesPerRow * TILE_SIZE * TILE_SIZE;
+				break;
+			case MORTON_LAYOUT:
+				size = (size_t)side * side;
+				break;
+			default:
+				size = (size_t)rows * cols;
+				break;
+		}
+	}
+
+	// Array index of a cell
+	inline int Index(int row, int col) const
+	{
+		switch (layout)
+		{
+			case TILED_LAYOUT:
+				return ((((row >> TILE_SHIFT) * tilesPerRow) + (col >> TILE_SHIFT)) << (2 * TILE_SHIFT))
+					| ((row & (TILE_SIZE - 1)) << TILE_SHIFT)
+					| (col & (TILE_SIZE - 1));
+			case MORTON_LAYOUT:
+				return (int)(SpreadBits((unsigned int)row) << 1 | SpreadBits((unsigned int)col));
+			default:
+				return row * cols + col;
+		}
+	}
+
+	// Cell at an array index (inverse of Index)
+	inline std::pair<int, int> Coordinates(int index) const
+	{
+		switch (layout)
+		{
+			case TILED_LAYOUT:
+			{
+				int tile = index >> (2 * TILE_SHIFT);
+				int inTile = index & (TILE_SIZE * TILE_SIZE - 1);
+				return std::make_pair(
+					((tile / tilesPerRow) << TILE_SHIFT) | (inTile >> TILE_SHIFT),
+					((tile % tilesPerRow) << TILE_SHIFT) | (inTile & (TILE_SIZE - 1)));
+			}
+			case MORTON_LAYOUT:
+				return std::make_pair(
+					(int)CompactBits((unsigned int)index >> 1),
+					(int)CompactBits((unsigned int)index));
+			default:
+				return std::make_pair(index / cols, index % cols);
+		}
+	}
+
+	// Number of entries a per-cell array needs (padding included)
+	size_t Size() const { return size; }
+
+	int Rows() const { return rows; }
+	int Cols() const { return cols; }
+	eGridLayout Layout() const { return layout; }
+
+private:
+	static const int TILE_SHIFT = 3;
+	static const int TILE_SIZE = 1 << TILE_SHIFT;
+
+	// 0b0000abcd -> 0b0a0b0c0d (lower 16 bits)
+	static inline unsigned int SpreadBits(unsigned int x)
+	{
+		x &= 0x0000ffff;
+		x = (x | (x << 8)) & 0x00ff00ff;
+		x = (x | (x << 4)) & 0x0f0f0f0f;
+		x = (x | (x << 2)) & 0x33333333;
+		x = (x | (x << 1)) & 0x55555555;
+		return x;
+	}
+
+	// 0bx a x b x c x d -> 0b0000abcd
+	static inline unsigned int CompactBits(unsigned int x)
+	{
+		x &= 0x55555555;
+		x = (x | (x >> 1)) & 0x33333333;
+		x = (x | (x >> 2)) & 0x0f0f0f0f;
+		x = (x | (x >> 4)) & 0x00ff00ff;
+		x = (x | (x >> 8)) & 0x0000ffff;
+		return x;
+	}
+
+	eGridLayout layout;
+	int rows;
+	int cols;
+	int tilesPerRow;
+	size_t size;
+};
@@ -0,0 +1,42 @@
+#include "cMapEditor.h"
+
+cMapEditor::cMapEditor()
+	: grid(nullptr)
+	, symmetry(nullptr)
+{
+}
+
+cMapEditor::~cMapEditor() {
+
+}
+
+void cMapEditor::Attach(cPathGrid* grid, cRectangularSymmetry* symmetry) {
+
+	this->grid = grid;
+	this->symmetry = symmetry;
+}
+
+bool cMapEditor::SetWalkable(int row, int col, bool walkable) {
+
+	lastEdit = sMapEditStats();
+
+	if (grid == nullptr || !grid->IsInside(row, col) || grid->IsWalkable(row, col) == walkable)
+		return false;
+
+	grid->SetWalkable(row, col, walkable);
+
+	lastEdit.clearanceCells = grid->UpdateClearance(row, col);
+
+	if (symmetry != nullptr)
+		lastEdit.symmetryCells = symmetry->UpdateCell(*grid, row, col);
+
+	return true;
+}
+
+bool cMapEditor::ToggleWall(int row, int col) {
+
+	if (grid == nullptr || !grid->IsInside(row, col))
+		return false;
+
+	return SetWalkable(row, col, !grid->IsWalkable(row, col));
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+// Edits single cells of a map while it's in use.
+//
+// Everything derived from the walkability grid is patched in place
+// rather than rebuilt: only the clearance of the cells the edit can
+// reach is redone, and only the symmetry rectangle the edit touches is
+// split (or a new one added), so an edit costs about the same on a
+// 64 x 64 map as on a huge one.
+
+#include "cPathGrid.h"
+#include "cRectangularSymmetry.h"
+
+// Work done by the last edit
+struct sMapEditStats {
+	// Cells whose clearance was recomputed
+	int clearanceCells = 0;
+	// Cells that were split into new symmetry rectangles
+	int symmetryCells = 0;
+};
+
+class cMapEditor {
+public:
+	cMapEditor();
+	~cMapEditor();
+
+	// The decomposition may be null, it has to have been built from
+	// the grid otherwise
+	void Attach(cPathGrid* grid, cRectangularSymmetry* symmetry);
+
+	// Returns false if the cell is outside the map or already that way
+	bool SetWalkable(int row, int col, bool walkable);
+
+	// Wall to open cell and back
+	bool ToggleWall(int row, int col);
+
+	const sMapEditStats& GetLastEditStats() const { return lastEdit; }
+
+private:
+	cPathGrid* grid;
+	cRectangularSymmetry* symmetry;
+
+	sMapEditStats lastEdit;
+};
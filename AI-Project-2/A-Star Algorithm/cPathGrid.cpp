@@ -0,0 +1,145 @@
+#include "cPathGrid.h"
+
+cPathGrid::cPathGrid() {
+
+}
+
+cPathGrid::cPathGrid(int rows, int cols, eGridLayout layout) {
+
+	Resize(rows, cols, layout);
+}
+
+cPathGrid::~cPathGrid() {
+
+}
+
+void cPathGrid::Resize(int rows, int cols, eGridLayout layout) {
+
+	this->layout = cGridLayout(rows, cols, layout);
+
+	cells.assign(this->layout.Size(), 0);
+	clearance.assign(this->layout.Size(), 0);
+}
+
+void cPathGrid::ChangeLayout(eGridLayout layout) {
+
+	cPathGrid copy(Rows(), Cols(), layout);
+
+	for (int i = 0; i < Rows(); i++) {
+		for (int j = 0; j < Cols(); j++) {
+			copy.SetWalkable(i, j, IsWalkable(i, j));
+			copy.clearance[copy.layout.Index(i, j)] = clearance[this->layout.Index(i, j)];
+		}
+	}
+
+	this->layout = copy.layout;
+	cells.swap(copy.cells);
+	clearance.swap(copy.clearance);
+}
+
+// A single pass from the bottom row up. The clearance of a cell is
+//
+//     min(run of walkable cells to its right,
+//         run of walkable cells below it,
+//         clearance of the cell down and to the right + 1)
+//
+// so each row only needs the row below it. The run below and the
+// diagonal term are plain branchless loops over contiguous bytes that
+// the compiler turns into SIMD code, only the run to the right is a
+// scalar scan along the row.
+void cPathGrid::UpdateClearance() {
+
+	int rows = Rows();
+	int cols = Cols();
+
+	// One extra blocked column on the right, so c + 1 is always valid
+	std::vector<unsigned char> walkable(cols + 1, 0);
+	std::vector<unsigned char> runRight(cols + 1, 0);
+	std::vector<unsigned char> runDown(cols + 1, 0);
+	std::vector<unsigned char> below(cols + 1, 0);
+	std::vector<unsigned char> current(cols + 1, 0);
+
+	for (int i = rows - 1; i >= 0; i--) {
+		for (int j = 0; j < cols; j++) {
+			walkable[j] = cells[layout.Index(i, j)];
+		}
+
+		for (int j = cols - 1; j >= 0; j--) {
+			unsigned char run = runRight[j + 1];
+			runRight[j] = (unsigned char)((run + (run < MAX_CLEARANCE)) & (0 - walkable[j]));
+		}
+
+		for (int j = 0; j < cols; j++) {
+			unsigned char mask = (unsigned char)(0 - walkable[j]);
+
+			unsigned char down = runDown[j];
+			down = (unsigned char)((down + (down < MAX_CLEARANCE)) & mask);
+			runDown[j] = down;
+
+			unsigned char diagonal = below[j + 1];
+			diagonal = (unsigned char)(diagonal + (diagonal < MAX_CLEARANCE));
+
+			unsigned char value = runRight[j];
+			value = (down < value) ? down : value;
+			value = (diagonal < value) ? diagonal : value;
+			current[j] = value & mask;
+		}
+
+		for (int j = 0; j < cols; j++) {
+			clearance[layout.Index(i, j)] = current[j];
+		}
+
+		below.swap(current);
+	}
+}
+
+// The same clearance as above, written as the largest square rule
+//
+//     1 + min(right, below, below right)
+//
+// A cell only feeds the cells above and to the left of it, so after an
+// edit the rows are redone from the edited one upwards, over the
+// MAX_CLEARANCE columns it can reach, until a row comes out unchanged.
+int cPathGrid::UpdateClearance(int row, int col) {
+
+	if (!IsInside(row, col))
+		return 0;
+
+	auto clearanceAt = [&](int r, int c) -> int {
+		return IsInside(r, c) ? clearance[layout.Index(r, c)] : 0;
+	};
+
+	int first = (col - MAX_CLEARANCE > 0) ? col - MAX_CLEARANCE : 0;
+	int visited = 0;
+
+	for (int i = row; i >= 0 && i > row - MAX_CLEARANCE; i--) {
+		bool changed = false;
+
+		for (int j = col; j >= first; j--) {
+			int index = layout.Index(i, j);
+			int value = 0;
+
+			if (cells[index] != 0) {
+				int right = clearanceAt(i, j + 1);
+				int below = clearanceAt(i + 1, j);
+				int diagonal = clearanceAt(i + 1, j + 1);
+
+				value = (right < below) ? right : below;
+				value = (diagonal < value) ? diagonal : value;
+				value = (value < MAX_CLEARANCE) ? value + 1 : MAX_CLEARANCE;
+			}
+
+			if (clearance[index] != value) {
+				clearance[index] = (unsigned char)value;
+				changed = true;
+			}
+			visited++;
+		}
+
+		// Nothing left to pass on to the row above
+		if (!changed)
+			break;
+	}
+
+	return visited;
+}
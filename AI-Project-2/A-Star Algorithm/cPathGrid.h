@@ -0,0 +1,81 @@
+#pragma once
+
+// Walkability grid the path finding algorithms search on.
+// Cells are stored in the order of the chosen cGridLayout, and all
+// per-cell search state should use the same layout (see GetLayout()).
+//
+// Every cell also has a true clearance: the size of the largest all
+// walkable square whose top left corner is the cell. An agent of size
+// n x n fits on a cell when its clearance is at least n, so one grid
+// serves agents of every size.
+
+#include <vector>
+#include <utility>
+
+#include "cGridLayout.h"
+
+// Creating a shortcut for int, int pair type
+typedef std::pair<int, int> Pair;
+
+class cPathGrid {
+public:
+	cPathGrid();
+	cPathGrid(int rows, int cols, eGridLayout layout = ROW_MAJOR_LAYOUT);
+	~cPathGrid();
+
+	// Every cell starts out blocked
+	void Resize(int rows, int cols, eGridLayout layout = ROW_MAJOR_LAYOUT);
+
+	// Same cells, stored in another layout
+	void ChangeLayout(eGridLayout layout);
+
+	int Rows() const { return layout.Rows(); }
+	int Cols() const { return layout.Cols(); }
+
+	const cGridLayout& GetLayout() const { return layout; }
+
+	bool IsInside(int row, int col) const
+	{
+		return (row >= 0) && (row < layout.Rows())
+			&& (col >= 0) && (col < layout.Cols());
+	}
+
+	bool IsWalkable(int row, int col) const
+	{
+		return cells[layout.Index(row, col)] != 0;
+	}
+
+	void SetWalkable(int row, int col, bool walkable)
+	{
+		cells[layout.Index(row, col)] = walkable ? 1 : 0;
+	}
+
+	// Recompute the clearance of every cell, call it after the
+	// walkability has changed
+	void UpdateClearance();
+
+	// Recompute only what a change of one cell affects: the cells above
+	// and to the left of it, up to MAX_CLEARANCE away, stopping at the
+	// first row that didn't change. Returns the number of cells visited.
+	int UpdateClearance(int row, int col);
+
+	// 0 for blocked cells, capped at MAX_CLEARANCE
+	int Clearance(int row, int col) const
+	{
+		return clearance[layout.Index(row, col)];
+	}
+
+	static const int MAX_CLEARANCE = 255;
+
+	// Raw cells and clearance, Size() bytes each in layout order.
+	// Used to save and restore precomputed maps.
+	const unsigned char* CellData() const { return cells.data(); }
+	unsigned char* CellData() { return cells.data(); }
+	const unsigned char* ClearanceData() const { return clearance.data(); }
+	unsigned char* ClearanceData() { return clearance.data(); }
+
+private:
+	cGridLayout layout;
+	std::vector<unsigned char> cells;
+	std::vector<unsigned char> clearance;
+};
@@ -0,0 +1,374 @@
+#include "cRectangularSymmetry.h"
+
+#include <cstdlib>
+
+// Left in the slot of a rectangle that was split, until it's reused
+static const sRectangle EMPTY_RECTANGLE = { 0, 0, -1, -1 };
+
+cRectangularSymmetry::cRectangularSymmetry() {
+
+}
+
+cRectangularSymmetry::~cRectangularSymmetry() {
+
+}
+
+void cRectangularSymmetry::Build(const cPathGrid& grid) {
+
+	layout = grid.GetLayout();
+
+	rectangles.clear();
+	freeIds.clear();
+	rectangleOfCell.assign(layout.Size(), -1);
+
+	growRectangles(grid, 0, 0, grid.Rows() - 1, grid.Cols() - 1);
+}
+
+void cRectangularSymmetry::growRectangles(const cPathGrid& grid, int top, int left, int bottom, int right) {
+
+	// Walkable and not part of any rectangle yet
+	auto isFree = [&](int row, int col) {
+		return grid.IsWalkable(row, col) && rectangleOf(row, col) == -1;
+	};
+
+	for (int i = top; i <= bottom; i++) {
+		for (int j = left; j <= right; j++) {
+			if (!isFree(i, j))
+				continue;
+
+			// Grow along the row first, then down
+			sRectangle wide = { i, j, i, j };
+			while (wide.right + 1 <= right && isFree(i, wide.right + 1)) {
+				wide.right++;
+			}
+			while (wide.bottom + 1 <= bottom) {
+				bool rowFree = true;
+				for (int c = wide.left; c <= wide.right && rowFree; c++) {
+					rowFree = isFree(wide.bottom + 1, c);
+				}
+				if (!rowFree)
+					break;
+				wide.bottom++;
+			}
+
+			// Grow along the column first, then right
+			sRectangle tall = { i, j, i, j };
+			while (tall.bottom + 1 <= bottom && isFree(tall.bottom + 1, j)) {
+				tall.bottom++;
+			}
+			while (tall.right + 1 <= right) {
+				bool colFree = true;
+				for (int r = tall.top; r <= tall.bottom && colFree; r++) {
+					colFree = isFree(r, tall.right + 1);
+				}
+				if (!colFree)
+					break;
+				tall.right++;
+			}
+
+			// Keep whichever covers more cells
+			int wideArea = (wide.bottom - wide.top + 1) * (wide.right - wide.left + 1);
+			int tallArea = (tall.bottom - tall.top + 1) * (tall.right - tall.left + 1);
+
+			addRectangle((wideArea >= tallArea) ? wide : tall);
+		}
+	}
+}
+
+int cRectangularSymmetry::addRectangle(const sRectangle& rect) {
+
+	// Slots of split rectangles are reused first
+	int id;
+	if (!freeIds.empty()) {
+		id = freeIds.back();
+		freeIds.pop_back();
+		rectangles[id] = rect;
+	}
+	else {
+		id = (int)rectangles.size();
+		rectangles.push_back(rect);
+	}
+
+	for (int r = rect.top; r <= rect.bottom; r++) {
+		for (int c = rect.left; c <= rect.right; c++) {
+			rectangleOfCell[layout.Index(r, c)] = id;
+		}
+	}
+
+	return id;
+}
+
+int cRectangularSymmetry::UpdateCell(const cPathGrid& grid, int row, int col) {
+
+	if (!grid.IsInside(row, col) || rectangleOfCell.size() != layout.Size())
+		return 0;
+
+	int id = rectangleOf(row, col);
+
+	// A new open cell gets a rectangle of its own
+	if (grid.IsWalkable(row, col) && id == -1) {
+		sRectangle rect = { row, col, row, col };
+		addRectangle(rect);
+		return 1;
+	}
+
+	// A new wall splits its rectangle, only that rectangle's cells are
+	// decomposed again
+	if (!grid.IsWalkable(row, col) && id != -1) {
+		sRectangle rect = rectangles[id];
+
+		for (int r = rect.top; r <= rect.bottom; r++) {
+			for (int c = rect.left; c <= rect.right; c++) {
+				rectangleOfCell[layout.Index(r, c)] = -1;
+			}
+		}
+
+		rectangles[id] = EMPTY_RECTANGLE;
+		freeIds.push_back(id);
+
+		growRectangles(grid, rect.top, rect.left, rect.bottom, rect.right);
+
+		return (rect.bottom - rect.top + 1) * (rect.right - rect.left + 1);
+	}
+
+	return 0;
+}
+
+bool cRectangularSymmetry::SetRectangles(const std::vector<sRectangle>& rectangles, const cPathGrid& grid) {
+
+	this->rectangles = rectangles;
+	layout = grid.GetLayout();
+
+	if (!indexRectangles(grid)) {
+		this->rectangles.clear();
+		rectangleOfCell.clear();
+		return false;
+	}
+
+	return true;
+}
+
+bool cRectangularSymmetry::Matches(const cPathGrid& grid) const {
+
+	if (layout.Rows() != grid.Rows() || layout.Cols() != grid.Cols()
+		|| layout.Layout() != grid.GetLayout().Layout()
+		|| rectangleOfCell.size() != layout.Size())
+		return false;
+
+	for (int i = 0; i < grid.Rows(); i++) {
+		for (int j = 0; j < grid.Cols(); j++) {
+			if (grid.IsWalkable(i, j) != (rectangleOf(i, j) != -1))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+bool cRectangularSymmetry::indexRectangles(const cPathGrid& grid) {
+
+	rectangleOfCell.assign(layout.Size(), -1);
+	freeIds.clear();
+
+	size_t covered = 0;
+
+	for (int k = 0; k < rectangles.size(); k++) {
+		const sRectangle& rect = rectangles[k];
+
+		if (IsEmpty(rect)) {
+			freeIds.push_back(k);
+			continue;
+		}
+
+		if (rect.left > rect.right
+			|| !grid.IsInside(rect.top, rect.left)
+			|| !grid.IsInside(rect.bottom, rect.right))
+			return false;
+
+		// Rectangles have to be empty and can't overlap
+		for (int r = rect.top; r <= rect.bottom; r++) {
+			for (int c = rect.left; c <= rect.right; c++) {
+				int index = layout.Index(r, c);
+				if (grid.CellData()[index] == 0 || rectangleOfCell[index] != -1)
+					return false;
+				rectangleOfCell[index] = k;
+			}
+		}
+
+		covered += (size_t)(rect.bottom - rect.top + 1) * (rect.right - rect.left + 1);
+	}
+
+	// Every walkable cell has to be covered. The rectangles only hold
+	// walkable cells and don't overlap, so counting them is enough.
+	const unsigned char* cells = grid.CellData();
+	size_t walkable = 0;
+	for (size_t k = 0; k < layout.Size(); k++) {
+		walkable += (cells[k] != 0);
+	}
+
+	return covered == walkable;
+}
+
+void cRectangularSymmetry::addSuccessor(Pair cell, double cost,
+	std::vector<Pair>& successors, std::vector<double>& costs) {
+
+	// Corners can be reached from two sides
+	for (int k = 0; k < successors.size(); k++) {
+		if (successors[k] == cell)
+			return;
+	}
+
+	successors.push_back(cell);
+	costs.push_back(cost);
+}
+
+void cRectangularSymmetry::ReduceSuccessors(int row, int col, Pair src, Pair dest,
+	std::vector<Pair>& successors, std::vector<double>& costs) const {
+
+	int id = rectangleOf(row, col);
+	if (id == -1)
+		return;
+
+	const sRectangle& rect = rectangles[id];
+	Pair cell = std::make_pair(row, col);
+
+	// The source or destination inside an interior is linked to the
+	// whole perimeter, any path out of the rectangle crosses it
+	if (isInterior(rect, row, col)) {
+		successors.clear();
+		costs.clear();
+
+		for (int c = rect.left; c <= rect.right; c++) {
+			addSuccessor(std::make_pair(rect.top, c), OctileCost(cell, std::make_pair(rect.top, c)), successors, costs);
+			addSuccessor(std::make_pair(rect.bottom, c), OctileCost(cell, std::make_pair(rect.bottom, c)), successors, costs);
+		}
+		for (int r = rect.top + 1; r < rect.bottom; r++) {
+			addSuccessor(std::make_pair(r, rect.left), OctileCost(cell, std::make_pair(r, rect.left)), successors, costs);
+			addSuccessor(std::make_pair(r, rect.right), OctileCost(cell, std::make_pair(r, rect.right)), successors, costs);
+		}
+	}
+	else {
+		// Drop the neighbours in the interior
+		int kept = 0;
+		for (int k = 0; k < successors.size(); k++) {
+			if (rectangleOf(successors[k].first, successors[k].second) == id
+				&& isInterior(rect, successors[k].first, successors[k].second))
+				continue;
+
+			successors[kept] = successors[k];
+			costs[kept] = costs[k];
+			kept++;
+		}
+		successors.resize(kept);
+		costs.resize(kept);
+
+		int height = rect.bottom - rect.top;
+		int width = rect.right - rect.left;
+
+		// Thin rectangles have no interior, nothing to jump over
+		bool hasInterior = (height >= 2 && width >= 2);
+
+		// Straight across, to every cell of the opposite side that a
+		// diagonal-then-straight path reaches
+		if (hasInterior && (row == rect.top || row == rect.bottom)) {
+			int other = (row == rect.top) ? rect.bottom : rect.top;
+			int first = (col - height > rect.left) ? col - height : rect.left;
+			int last = (col + height < rect.right) ? col + height : rect.right;
+
+			for (int c = first; c <= last; c++) {
+				Pair to = std::make_pair(other, c);
+				addSuccessor(to, OctileCost(cell, to), successors, costs);
+			}
+		}
+		if (hasInterior && (col == rect.left || col == rect.right)) {
+			int other = (col == rect.left) ? rect.right : rect.left;
+			int first = (row - width > rect.top) ? row - width : rect.top;
+			int last = (row + width < rect.bottom) ? row + width : rect.bottom;
+
+			for (int r = first; r <= last; r++) {
+				Pair to = std::make_pair(r, other);
+				addSuccessor(to, OctileCost(cell, to), successors, costs);
+			}
+		}
+
+		// Diagonally onto the sides next to this one. Landing on an
+		// opposite side is already covered above.
+		for (int dRow = -1; dRow <= 1; dRow += 2) {
+			for (int dCol = -1; dCol <= 1; dCol += 2) {
+				int r = row + dRow;
+				int c = col + dCol;
+
+				if (!isInterior(rect, r, c))
+					continue;
+
+				while (isInterior(rect, r, c)) {
+					r += dRow;
+					c += dCol;
+				}
+
+				bool opposite = (row == rect.top && r == rect.bottom)
+					|| (row == rect.bottom && r == rect.top)
+					|| (col == rect.left && c == rect.right)
+					|| (col == rect.right && c == rect.left);
+
+				if (!opposite) {
+					Pair to = std::make_pair(r, c);
+					addSuccessor(to, OctileCost(cell, to), successors, costs);
+				}
+			}
+		}
+	}
+
+	// Interior source/destination of this rectangle
+	Pair ends[2] = { src, dest };
+	for (int k = 0; k < 2; k++) {
+		if (ends[k] == cell || ends[k].first < 0 || ends[k].second < 0
+			|| ends[k].first >= layout.Rows() || ends[k].second >= layout.Cols())
+			continue;
+
+		if (rectangleOf(ends[k].first, ends[k].second) == id
+			&& isInterior(rect, ends[k].first, ends[k].second))
+			addSuccessor(ends[k], OctileCost(cell, ends[k]), successors, costs);
+	}
+}
+
+void cRectangularSymmetry::ExpandMacroEdge(Pair from, Pair to, std::vector<Pair>& cells) {
+
+	int r = from.first;
+	int c = from.second;
+
+	while (r != to.first || c != to.second) {
+		if (r != to.first)
+			r += (to.first > r) ? 1 : -1;
+		if (c != to.second)
+			c += (to.second > c) ? 1 : -1;
+
+		cells.push_back(std::make_pair(r, c));
+	}
+}
+
+double cRectangularSymmetry::OctileCost(Pair from, Pair to) {
+
+	int dRow = abs(to.first - from.first);
+	int dCol = abs(to.second - from.second);
+
+	int diagonal = (dRow < dCol) ? dRow : dCol;
+	int straight = ((dRow > dCol) ? dRow : dCol) - diagonal;
+
+	return diagonal * 1.414 + straight * 1.0;
+}
+
+int cRectangularSymmetry::InteriorCellCount() const {
+
+	int count = 0;
+
+	for (int k = 0; k < rectangles.size(); k++) {
+		int height = rectangles[k].bottom - rectangles[k].top - 1;
+		int width = rectangles[k].right - rectangles[k].left - 1;
+
+		if (height > 0 && width > 0)
+			count += height * width;
+	}
+
+	return count;
+}
@@ -75,6 +75,10 @@ void draw_bbox(cMeshInfo* mesh, unsigned int shaderID, glm::mat4 meshTransform)
     
     glUniformMatrix4fv(modelLocaction, 1, GL_FALSE, glm::value_ptr(model));
 
+    // The box corners are plain floats, whatever the mesh was
+    GLint bQuantizedVertexLocation = glGetUniformLocation(shaderID, "bQuantizedVertex");
+    glUniform1f(bQuantizedVertexLocation, (GLfloat)GL_FALSE);
+
     GLint vpos_location;
     vpos_location = glGetAttribLocation(shaderID, "vPosition");
 
@@ -4,9 +4,98 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <iostream>
+#include <cmath>
 
 #include "../Draw Bounding Box/DrawBoundingBox.h"
 
+// A level of detail is good enough while it's off by at most this much
+const float LOD_PIXEL_ERROR = 1.f;
+
+// Pixels a world unit covers at a distance of 1, see SetLODProjection
+static float lodPixelsPerUnit = 0.f;
+
+void SetLODProjection(float verticalFov, int viewportHeight) {
+
+    lodPixelsPerUnit = viewportHeight / (2.f * tanf(verticalFov * 0.5f));
+}
+
+// The VAO the last draw left bound. Models in the shared buffers all
+// have the same one, so drawing them back to back binds it once.
+static GLuint boundVAO = 0;
+
+static void BindVAO(GLuint vaoID) {
+
+    if (vaoID != boundVAO) {
+        glBindVertexArray(vaoID);
+        boundVAO = vaoID;
+    }
+}
+
+void InvalidateBoundVAO() {
+
+    // No VAO has this name, the next BindVAO always binds
+    boundVAO = ~0u;
+}
+
+// Tells the vertex shader how to read the model's vertices
+static void SetVertexFormat(GLuint shaderID, const sModelDrawInfo& modelInfo) {
+
+    GLint bQuantizedVertexLocation = glGetUniformLocation(shaderID, "bQuantizedVertex");
+
+    if (modelInfo.isQuantized)
+    {
+        glUniform1f(bQuantizedVertexLocation, (GLfloat)GL_TRUE);
+
+        GLint meshBoundsMinLocation = glGetUniformLocation(shaderID, "meshBoundsMin");
+        glUniform4f(meshBoundsMinLocation, modelInfo.minX, modelInfo.minY, modelInfo.minZ, 1.f);
+
+        GLint meshBoundsExtentLocation = glGetUniformLocation(shaderID, "meshBoundsExtent");
+        glUniform4f(meshBoundsExtentLocation, modelInfo.extentX, modelInfo.extentY, modelInfo.extentZ, 0.f);
+    }
+    else
+    {
+        glUniform1f(bQuantizedVertexLocation, (GLfloat)GL_FALSE);
+    }
+}
+
+// The coarsest level whose error is still under LOD_PIXEL_ERROR on
+// screen, measured from the nearest point of the model's bounding sphere
+static void SelectLOD(const sModelDrawInfo& modelInfo, const glm::mat4& matModel, const glm::vec3& eye,
+    unsigned int& firstIndex, unsigned int& numberOfIndices) {
+
+    firstIndex = 0;
+    numberOfIndices = modelInfo.numberOfIndices;
+
+    if (modelInfo.numberOfLODs == 0 || lodPixelsPerUnit <= 0.f) {
+        return;
+    }
+
+    glm::vec3 centre = glm::vec3(modelInfo.minX + modelInfo.maxX,
+        modelInfo.minY + modelInfo.maxY, modelInfo.minZ + modelInfo.maxZ) * 0.5f;
+    centre = glm::vec3(matModel * glm::vec4(centre, 1.f));
+
+    float scale = glm::max(glm::length(glm::vec3(matModel[0])),
+        glm::max(glm::length(glm::vec3(matModel[1])), glm::length(glm::vec3(matModel[2]))));
+
+    float radius = 0.5f * scale * glm::length(glm::vec3(modelInfo.extentX, modelInfo.extentY, modelInfo.extentZ));
+    float distance = glm::length(centre - eye) - radius;
+
+    // Camera inside the bounds, full detail
+    if (distance <= 0.f) {
+        return;
+    }
+
+    float pixelsPerUnit = scale * lodPixelsPerUnit / distance;
+
+    for (unsigned int level = modelInfo.numberOfLODs; level-- > 0;) {
+        if (modelInfo.lods[level].error * pixelsPerUnit <= LOD_PIXEL_ERROR) {
+            firstIndex = modelInfo.lods[level].firstIndex;
+            numberOfIndices = modelInfo.lods[level].numberOfIndices;
+            return;
+        }
+    }
+}
+
 // Function for drawing individual meshes
 void DrawMesh(cMeshInfo* currentMesh,
     glm::mat4 model,
@@ -168,12 +257,22 @@ void DrawMesh(cMeshInfo* currentMesh,
         glUniform1f(bIsSkyboxObjectLocation, (GLfloat)GL_FALSE);
     }
 
-    sModelDrawInfo modelInfo;
-    if (VAOManager->FindDrawInfoByModelName(currentMesh->meshName, modelInfo)) {
+    if (currentMesh->meshHandle == cVAOManager::INVALID_MESH_HANDLE) {
+        currentMesh->meshHandle = VAOManager->GetMeshHandle(currentMesh->meshName);
+    }
+
+    if (currentMesh->meshHandle != cVAOManager::INVALID_MESH_HANDLE) {
+
+        const sModelDrawInfo& modelInfo = *VAOManager->GetDrawInfo(currentMesh->meshHandle);
 
-        glBindVertexArray(modelInfo.VAO_ID);
-        glDrawElements(GL_TRIANGLES, modelInfo.numberOfIndices, GL_UNSIGNED_INT, (void*)0);
-        glBindVertexArray(0);
+        unsigned int firstIndex, numberOfIndices;
+        SelectLOD(modelInfo, matModel, camera->position, firstIndex, numberOfIndices);
+        SetVertexFormat(shaderID, modelInfo);
+
+        BindVAO(modelInfo.VAO_ID);
+        glDrawElementsBaseVertex(GL_TRIANGLES, numberOfIndices, GL_UNSIGNED_INT,
+            (void*)(sizeof(unsigned int) * (modelInfo.IndexBuffer_Start_Index + firstIndex)),
+            modelInfo.VertexBuffer_Start_Index);
     }
     else {
         std::cout << "Model not found." << std::endl;
@@ -199,6 +298,8 @@ void DrawMesh(cMeshInfo* currentMesh,
         // pass in the model matrix after drawing
         // so it doesnt screw with the matrix values
 
+        // It sets up its attributes on whatever VAO is bound
+        BindVAO(0);
         draw_bbox(currentMesh, shaderID, matModel);
     }
 
@@ -348,12 +449,22 @@ void DrawMesh(cMeshInfo* currentMesh,
         glUniform1f(bIsSkyboxObjectLocation, (GLfloat)GL_FALSE);
     }
 
-    sModelDrawInfo modelInfo;
-    if (VAOManager->FindDrawInfoByModelName(currentMesh->meshName, modelInfo)) {
+    if (currentMesh->meshHandle == cVAOManager::INVALID_MESH_HANDLE) {
+        currentMesh->meshHandle = VAOManager->GetMeshHandle(currentMesh->meshName);
+    }
+
+    if (currentMesh->meshHandle != cVAOManager::INVALID_MESH_HANDLE) {
+
+        const sModelDrawInfo& modelInfo = *VAOManager->GetDrawInfo(currentMesh->meshHandle);
+
+        unsigned int firstIndex, numberOfIndices;
+        SelectLOD(modelInfo, matModel, camera->position, firstIndex, numberOfIndices);
+        SetVertexFormat(shaderID, modelInfo);
 
-        glBindVertexArray(modelInfo.VAO_ID);
-        glDrawElements(GL_TRIANGLES, modelInfo.numberOfIndices, GL_UNSIGNED_INT, (void*)0);
-        glBindVertexArray(0);
+        BindVAO(modelInfo.VAO_ID);
+        glDrawElementsBaseVertex(GL_TRIANGLES, numberOfIndices, GL_UNSIGNED_INT,
+            (void*)(sizeof(unsigned int) * (modelInfo.IndexBuffer_Start_Index + firstIndex)),
+            modelInfo.VertexBuffer_Start_Index);
     }
     else {
         std::cout << "Model not found." << std::endl;
@@ -379,12 +490,71 @@ void DrawMesh(cMeshInfo* currentMesh,
         // pass in the model matrix after drawing
         // so it doesnt screw with the matrix values
 
+        // It sets up its attributes on whatever VAO is bound
+        BindVAO(0);
         draw_bbox(currentMesh, shaderID, matModel);
     }
 
     return;
 }
 
+// Draws every visible copy in one call. The copies are placed and
+// coloured by the vertex shader, so only the state shared by all of
+// them is set here.
+void DrawInstancedMesh(cInstancedMesh* instancedMesh,
+    GLuint shaderID,
+    cVAOManager* VAOManager,
+    GLint modelULoc,
+    GLint modelInverseULoc) {
+
+    // Can rebuild its VAO, which binds and deletes them directly
+    bool prepared = instancedMesh->Prepare(VAOManager, shaderID);
+    InvalidateBoundVAO();
+
+    if (!prepared) {
+        std::cout << "Model not found." << std::endl;
+        return;
+    }
+
+    if (instancedMesh->NumberOfVisible() == 0) {
+        return;
+    }
+
+    glCullFace(GL_BACK);
+    glEnable(GL_CULL_FACE);
+    glEnable(GL_DEPTH_TEST);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    // The shader only uses the alpha, the colour comes with the instance
+    glUniformMatrix4fv(modelULoc, 1, GL_FALSE, glm::value_ptr(glm::mat4(1.f)));
+    glUniformMatrix4fv(modelInverseULoc, 1, GL_FALSE, glm::value_ptr(glm::mat4(1.f)));
+
+    glUniform1f(glGetUniformLocation(shaderID, "bIsTerrainMesh"), (GLfloat)GL_FALSE);
+    glUniform4f(glGetUniformLocation(shaderID, "RGBAColour"), 0.f, 0.f, 0.f, 1.f);
+    glUniform1f(glGetUniformLocation(shaderID, "useRGBAColour"), (GLfloat)GL_FALSE);
+    glUniform1f(glGetUniformLocation(shaderID, "bHasTexture"), (GLfloat)GL_FALSE);
+    glUniform1f(glGetUniformLocation(shaderID, "doNotLight"), (GLfloat)GL_FALSE);
+    glUniform1f(glGetUniformLocation(shaderID, "bIsSkyboxObject"), (GLfloat)GL_FALSE);
+
+    const sModelDrawInfo& modelInfo = *VAOManager->GetDrawInfo(instancedMesh->MeshHandle());
+    SetVertexFormat(shaderID, modelInfo);
+
+    GLint bIsInstancedLocation = glGetUniformLocation(shaderID, "bIsInstanced");
+    glUniform1f(bIsInstancedLocation, (GLfloat)GL_TRUE);
+
+    // Its own VAO, the mesh's attributes plus the per-instance ones
+    BindVAO(instancedMesh->VAO_ID());
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, modelInfo.numberOfIndices, GL_UNSIGNED_INT,
+        (void*)(sizeof(unsigned int) * modelInfo.IndexBuffer_Start_Index),
+        instancedMesh->NumberOfVisible(),
+        modelInfo.VertexBuffer_Start_Index);
+
+    glUniform1f(bIsInstancedLocation, (GLfloat)GL_FALSE);
+}
+
 //read scene description files
 void ReadSceneDescription(std::vector<cMeshInfo*>& meshArray) {
 
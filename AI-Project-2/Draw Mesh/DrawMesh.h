@@ -5,6 +5,7 @@
 #include "../cMeshInfo/cMeshInfo.h"
 #include "../sCamera.h"
 #include "../cVAOManager/cVAOManager.h"
+#include "../cInstancedMesh/cInstancedMesh.h"
 #include "../cBasicTextureManager/cBasicTextureManager.h"
 
 #include <vector>
@@ -30,4 +31,20 @@ void DrawMesh(cMeshInfo* currentMesh,
     GLint modelULoc,
     GLint modelInverseULoc);
 
+// Every visible copy of the mesh in one instanced draw call
+void DrawInstancedMesh(cInstancedMesh* instancedMesh,
+    GLuint shaderID,
+    cVAOManager* VAOManager,
+    GLint modelULoc,
+    GLint modelInverseULoc);
+
+// The draw functions skip binding a VAO that's still bound from the
+// previous draw. Call after binding or deleting one anywhere else, so
+// the next draw binds its own again.
+void InvalidateBoundVAO();
+
+// Screen the levels of detail are picked for, call whenever the
+// projection changes (field of view in radians)
+void SetLODProjection(float verticalFov, int viewportHeight);
+
 void ReadSceneDescription(std::vector<cMeshInfo*>& meshArray);
\ No newline at end of file
@@ -1,4 +1,232 @@
 #include "PlyFileLoader.h"
+#include "cMeshCache.h"
+#include "../cMappedFile/cMappedFile.h"
+#include "../cMeshOptimizer/cMeshOptimizer.h"
+#include "../cMeshOptimizer/cMeshSimplifier.h"
+
+#include <sstream>
+#include <cstring>
+#include <cstddef>
+#include <charconv>
+
+// Values of binary files are read and written in the machine's byte
+// order, which is little endian everywhere we build
+static size_t typeSize(PlyFileLoader::ePlyType type)
+{
+    switch (type)
+    {
+        case PlyFileLoader::PLY_INT8:
+        case PlyFileLoader::PLY_UINT8:
+            return 1;
+        case PlyFileLoader::PLY_INT16:
+        case PlyFileLoader::PLY_UINT16:
+            return 2;
+        case PlyFileLoader::PLY_INT32:
+        case PlyFileLoader::PLY_UINT32:
+        case PlyFileLoader::PLY_FLOAT32:
+            return 4;
+        case PlyFileLoader::PLY_FLOAT64:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+static PlyFileLoader::ePlyType typeFromName(const std::string& name)
+{
+    if (name == "char" || name == "int8") return PlyFileLoader::PLY_INT8;
+    if (name == "uchar" || name == "uint8") return PlyFileLoader::PLY_UINT8;
+    if (name == "short" || name == "int16") return PlyFileLoader::PLY_INT16;
+    if (name == "ushort" || name == "uint16") return PlyFileLoader::PLY_UINT16;
+    if (name == "int" || name == "int32") return PlyFileLoader::PLY_INT32;
+    if (name == "uint" || name == "uint32") return PlyFileLoader::PLY_UINT32;
+    if (name == "float" || name == "float32") return PlyFileLoader::PLY_FLOAT32;
+    if (name == "double" || name == "float64") return PlyFileLoader::PLY_FLOAT64;
+    return PlyFileLoader::PLY_INVALID;
+}
+
+static double readValue(const unsigned char* p, PlyFileLoader::ePlyType type)
+{
+    switch (type)
+    {
+        case PlyFileLoader::PLY_INT8:    { signed char v;    memcpy(&v, p, 1); return v; }
+        case PlyFileLoader::PLY_UINT8:   { unsigned char v;  memcpy(&v, p, 1); return v; }
+        case PlyFileLoader::PLY_INT16:   { short v;          memcpy(&v, p, 2); return v; }
+        case PlyFileLoader::PLY_UINT16:  { unsigned short v; memcpy(&v, p, 2); return v; }
+        case PlyFileLoader::PLY_INT32:   { int v;            memcpy(&v, p, 4); return v; }
+        case PlyFileLoader::PLY_UINT32:  { unsigned int v;   memcpy(&v, p, 4); return v; }
+        case PlyFileLoader::PLY_FLOAT32: { float v;          memcpy(&v, p, 4); return v; }
+        case PlyFileLoader::PLY_FLOAT64: { double v;         memcpy(&v, p, 8); return v; }
+        default:
+            return 0.0;
+    }
+}
+
+// Where a vertex property goes in vertLayout, -1 for the ones it has
+// no room for (alpha, ...)
+static int vertexOffset(const std::string& name)
+{
+    if (name == "x") return offsetof(vertLayout, x);
+    if (name == "y") return offsetof(vertLayout, y);
+    if (name == "z") return offsetof(vertLayout, z);
+    if (name == "red") return offsetof(vertLayout, r);
+    if (name == "green") return offsetof(vertLayout, g);
+    if (name == "blue") return offsetof(vertLayout, b);
+    if (name == "nx") return offsetof(vertLayout, nx);
+    if (name == "ny") return offsetof(vertLayout, ny);
+    if (name == "nz") return offsetof(vertLayout, nz);
+    if (name == "texture_u" || name == "u" || name == "s") return offsetof(vertLayout, texture_u);
+    if (name == "texture_v" || name == "v" || name == "t") return offsetof(vertLayout, texture_v);
+    return -1;
+}
+
+// Vertex properties in the order of vertLayout, what SaveBinary writes
+static const char* const VERTEX_PROPERTIES[] = {
+    "x", "y", "z", "red", "green", "blue", "nx", "ny", "nz", "texture_u", "texture_v"
+};
+static const size_t VERTEX_PROPERTY_COUNT = sizeof(VERTEX_PROPERTIES) / sizeof(VERTEX_PROPERTIES[0]);
+static const size_t PACKED_VERTEX_SIZE = VERTEX_PROPERTY_COUNT * sizeof(float);
+
+// A triangle as SaveBinary writes it: uchar 3, then 3 uint indices
+static const size_t PACKED_TRIANGLE_SIZE = 1 + 3 * sizeof(unsigned int);
+
+// Bytes of one element, 0 if it has lists and every record has to be walked
+static size_t recordSize(const PlyFileLoader::sPlyElement& element)
+{
+    size_t size = 0;
+    for (size_t k = 0; k < element.properties.size(); k++) {
+        if (element.properties[k].isList)
+            return 0;
+        size += typeSize(element.properties[k].type);
+    }
+    return size;
+}
+
+// Moves 'p' past a list, false if it runs past the end of the file
+static bool skipList(const PlyFileLoader::sPlyProperty& property, const unsigned char*& p, const unsigned char* end)
+{
+    size_t countSize = typeSize(property.countType);
+    if ((size_t)(end - p) < countSize)
+        return false;
+
+    size_t count = (size_t)readValue(p, property.countType);
+    p += countSize;
+
+    if ((size_t)(end - p) / typeSize(property.type) < count)
+        return false;
+
+    p += count * typeSize(property.type);
+    return true;
+}
+
+static bool skipElement(const PlyFileLoader::sPlyElement& element, const unsigned char*& p, const unsigned char* end)
+{
+    size_t stride = recordSize(element);
+    if (stride != 0 || element.properties.empty()) {
+        if (stride != 0 && (size_t)(end - p) / stride < element.count)
+            return false;
+        p += stride * element.count;
+        return true;
+    }
+
+    for (unsigned int k = 0; k < element.count; k++) {
+        for (size_t i = 0; i < element.properties.size(); i++) {
+            const PlyFileLoader::sPlyProperty& property = element.properties[i];
+
+            if (property.isList) {
+                if (!skipList(property, p, end))
+                    return false;
+            }
+            else {
+                if ((size_t)(end - p) < typeSize(property.type))
+                    return false;
+                p += typeSize(property.type);
+            }
+        }
+    }
+    return true;
+}
+
+// Faces can come before the vertices, so this runs once both are read
+static bool indicesInRange(const sModelDrawInfo& plyModel)
+{
+    for (unsigned int k = 0; k < plyModel.numberOfIndices; k++) {
+        if (plyModel.pIndices[k] >= plyModel.numberOfVertices)
+            return false;
+    }
+    return true;
+}
+
+static bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// Next value of an ASCII body, false at the end of the file or when it
+// isn't a number. Integer properties (colours, ...) are read the same way.
+static bool parseFloat(const char*& p, const char* end, float& value)
+{
+    while (p != end && isSpace(*p))
+        p++;
+
+    // from_chars doesn't take a leading '+'
+    if (p != end && *p == '+')
+        p++;
+
+    std::from_chars_result parsed = std::from_chars(p, end, value);
+
+    // Too small for a float, it's zero as far as we're concerned
+    if (parsed.ec == std::errc::result_out_of_range && parsed.ptr != p)
+        value = 0.f;
+    else if (parsed.ec != std::errc())
+        return false;
+
+    p = parsed.ptr;
+    return true;
+}
+
+static bool parseUnsigned(const char*& p, const char* end, unsigned int& value)
+{
+    while (p != end && isSpace(*p))
+        p++;
+
+    std::from_chars_result parsed = std::from_chars(p, end, value);
+    if (parsed.ec != std::errc())
+        return false;
+
+    p = parsed.ptr;
+    return true;
+}
+
+// Values we have no use for
+static bool skipValue(const char*& p, const char* end)
+{
+    while (p != end && isSpace(*p))
+        p++;
+
+    if (p == end)
+        return false;
+
+    while (p != end && !isSpace(*p))
+        p++;
+    return true;
+}
+
+static bool skipAsciiProperty(const PlyFileLoader::sPlyProperty& property, const char*& p, const char* end)
+{
+    if (!property.isList)
+        return skipValue(p, end);
+
+    unsigned int count;
+    if (!parseUnsigned(p, end, count))
+        return false;
+
+    for (unsigned int k = 0; k < count; k++) {
+        if (!skipValue(p, end))
+            return false;
+    }
+    return true;
+}
 
 PlyFileLoader::PlyFileLoader() {
 
@@ -10,132 +238,516 @@ PlyFileLoader::~PlyFileLoader() {
 
 sModelDrawInfo* PlyFileLoader::GetPlyModelByID(unsigned int id) {
 
-    return plyModels[id];
+    if (id >= plyModels.size()) {
+        return nullptr;
+    }
+
+    return &plyModels[id];
 }
 
 int PlyFileLoader::LoadModel(std::string fileName, sModelDrawInfo& plyModel) {
 
-    vertexLayout* modelArray = NULL;
-    triangleLayout* triangleArray = NULL;
-
-    std::ifstream plyFile(fileName);
-    if (!plyFile.is_open()) {
-        std::cout << "Could not load file." << std::endl;
+    if (!Load(fileName, plyModel)) {
         return -1;
     }
 
-    std::string input1;
+    plyModels.push_back(plyModel);
 
-    // Scan for the word "vertex"
-    while (plyFile >> input1)
-    {
-        if (input1 == "vertex")
-        {
-            break;
+    return plyModels.size() - 1;
+}
+
+bool PlyFileLoader::ParseHeader(const char* data, size_t size, sPlyHeader& header) {
+
+    header.format = PLY_ASCII;
+    header.elements.clear();
+    header.size = 0;
+
+    bool hasFormat = false;
+    size_t lineStart = 0;
+    int lineNumber = 0;
+
+    while (lineStart < size) {
+        const char* newLine = (const char*)memchr(data + lineStart, '\n', size - lineStart);
+        if (newLine == nullptr)
+            return false;
+
+        size_t lineEnd = newLine - data;
+        std::istringstream line(std::string(data + lineStart, lineEnd - lineStart));
+        lineStart = lineEnd + 1;
+        lineNumber++;
+
+        std::string keyword;
+        line >> keyword;
+
+        if (lineNumber == 1) {
+            if (keyword != "ply")
+                return false;
+        }
+        else if (keyword == "format") {
+            std::string format;
+            line >> format;
+
+            if (format == "ascii")
+                header.format = PLY_ASCII;
+            else if (format == "binary_little_endian")
+                header.format = PLY_BINARY_LITTLE_ENDIAN;
+            else if (format == "binary_big_endian")
+                header.format = PLY_BINARY_BIG_ENDIAN;
+            else
+                return false;
+
+            hasFormat = true;
         }
+        else if (keyword == "element") {
+            sPlyElement element;
+            if (!(line >> element.name >> element.count))
+                return false;
+
+            header.elements.push_back(element);
+        }
+        else if (keyword == "property") {
+            if (header.elements.empty())
+                return false;
+
+            sPlyProperty property;
+            std::string type;
+            line >> type;
+
+            if (type == "list") {
+                std::string countType;
+                line >> countType >> type;
+
+                property.isList = true;
+                property.countType = typeFromName(countType);
+                if (property.countType == PLY_INVALID || property.countType == PLY_FLOAT32
+                    || property.countType == PLY_FLOAT64)
+                    return false;
+            }
+            else {
+                property.isList = false;
+                property.countType = PLY_INVALID;
+            }
+
+            property.type = typeFromName(type);
+            if (property.type == PLY_INVALID || !(line >> property.name))
+                return false;
+
+            header.elements.back().properties.push_back(property);
+        }
+        else if (keyword == "end_header") {
+            header.size = lineStart;
+            return hasFormat;
+        }
+        // comment, obj_info and empty lines
     }
 
-    plyFile >> plyModel.numberOfVertices;
+    return false;
+}
 
-    // Scan for the word "face"
-    while (plyFile >> input1)
-    {
-        if (input1 == "face")
-        {
-            break;
-        }
+bool PlyFileLoader::Load(const std::string& fileName, sModelDrawInfo& plyModel, unsigned int cookFlags) {
+
+    if (cMeshCache::Load(fileName, plyModel, cookFlags)) {
+        return true;
     }
 
-    plyFile >> plyModel.numberOfTriangles;
+    if (!Parse(fileName, plyModel)) {
+        return false;
+    }
 
-    // Scan for the word "end_header"
-    while (plyFile >> input1)
-    {
-        if (input1 == "end_header")
-        {
-            break;
-        }
+    // Has to happen before cooking, cooked arrays are read only
+    if (cookFlags & cMeshCache::FLAG_OPTIMIZED) {
+        sMeshOptimizeStats stats;
+        cMeshOptimizer::Optimize(plyModel, stats);
+
+        std::ostringstream report;
+        report << fileName << ": " << stats.verticesBefore << " -> " << stats.verticesAfter
+            << " vertices, ACMR " << stats.acmrBefore << " -> " << stats.acmrAfter << "\n";
+        std::cout << report.str();
     }
 
-    //Vertex Layout
-    modelArray = new vertexLayout[plyModel.numberOfVertices];
+    plyModel.CalculateExtents();
+
+    // After optimizing, the simplifier needs the vertices welded
+    if (cookFlags & cMeshCache::FLAG_LODS) {
+        cMeshSimplifier::BuildLODs(plyModel);
+    }
 
-    std::cout << "Loading " << fileName << std::endl;
-    for (unsigned int count = 0; count != plyModel.numberOfVertices; count++)
+    // Cooked for next time
+    if (!cMeshCache::Save(fileName, plyModel, cookFlags)) {
+        std::cout << ("Could not cook " + fileName + "\n");
+    }
+
+    return true;
+}
+
+bool PlyFileLoader::Parse(const std::string& fileName, sModelDrawInfo& plyModel) {
+
+    cMappedFile file;
+    if (!file.Open(fileName)) {
+        std::cout << "Could not load file." << std::endl;
+        return false;
+    }
+
+    sPlyHeader header;
+    if (!PlyFileLoader::ParseHeader((const char*)file.Data(), file.Size(), header)) {
+        std::cout << fileName << " is not a PLY file." << std::endl;
+        return false;
+    }
+
+    bool loaded = false;
+
+    switch (header.format)
     {
-        plyFile >> modelArray[count].x;
-        plyFile >> modelArray[count].y;
-        plyFile >> modelArray[count].z;
+        case PLY_ASCII:
+            loaded = loadAscii(fileName, (const char*)file.Data(), file.Size(), header, plyModel);
+            break;
 
-        plyFile >> modelArray[count].nx;
-        plyFile >> modelArray[count].ny;
-        plyFile >> modelArray[count].nz;
+        case PLY_BINARY_LITTLE_ENDIAN:
+            loaded = loadBinary(fileName, file.Data(), file.Size(), header, plyModel);
+            break;
 
-        plyFile >> modelArray[count].r;
-        plyFile >> modelArray[count].g;
-        plyFile >> modelArray[count].b;
-        plyFile >> modelArray[count].a;
+        case PLY_BINARY_BIG_ENDIAN:
+            std::cout << fileName << " is big endian, convert it to little endian first." << std::endl;
+            return false;
+    }
 
-        plyFile >> modelArray[count].texture_u;
-        plyFile >> modelArray[count].texture_v;
-        int breakpoint = 1;
+    if (!loaded) {
+        plyModel.ReleaseArrays();
     }
 
-    triangleArray = new triangleLayout[plyModel.numberOfTriangles];
+    return loaded;
+}
 
-    // Triangle Layout
-    for (unsigned int count = 0; count != plyModel.numberOfTriangles; count++) {
-        unsigned int temp = 0;
-        plyFile >> temp;
+bool PlyFileLoader::loadBinary(const std::string& fileName, const unsigned char* data, size_t size,
+    const sPlyHeader& header, sModelDrawInfo& plyModel) {
+
+    const unsigned char* p = data + header.size;
+    const unsigned char* end = data + size;
+
+    bool hasVertices = false;
+    bool hasFaces = false;
+
+    // One write, lines of other loading threads don't end up in the middle
+    std::cout << ("Loading " + fileName + "\n");
+
+    for (size_t e = 0; e < header.elements.size(); e++) {
+        const sPlyElement& element = header.elements[e];
+
+        //----------- Vertices ------------
+        if (element.name == "vertex" && !hasVertices) {
+            size_t stride = recordSize(element);
+            if (stride == 0) {
+                std::cout << fileName << ": vertices can't have list properties." << std::endl;
+                return false;
+            }
+            if ((size_t)(end - p) / stride < element.count) {
+                std::cout << fileName << " is truncated." << std::endl;
+                return false;
+            }
+
+            // Floats in vertLayout order need no conversion
+            bool packed = (element.properties.size() == VERTEX_PROPERTY_COUNT);
+            for (size_t k = 0; packed && k < VERTEX_PROPERTY_COUNT; k++) {
+                packed = element.properties[k].type == PLY_FLOAT32
+                    && element.properties[k].name == VERTEX_PROPERTIES[k];
+            }
+
+            plyModel.numberOfVertices = element.count;
+            plyModel.pVertices = plyModel.NewVertices(element.count);
+
+            if (packed) {
+                for (unsigned int k = 0; k < element.count; k++) {
+                    memcpy(&plyModel.pVertices[k], p + k * PACKED_VERTEX_SIZE, PACKED_VERTEX_SIZE);
+                }
+            }
+            else {
+                std::vector<int> offsets(element.properties.size());
+                std::vector<size_t> positions(element.properties.size());
+
+                size_t position = 0;
+                for (size_t i = 0; i < element.properties.size(); i++) {
+                    offsets[i] = vertexOffset(element.properties[i].name);
+                    positions[i] = position;
+                    position += typeSize(element.properties[i].type);
+                }
+
+                for (unsigned int k = 0; k < element.count; k++) {
+                    const unsigned char* record = p + k * stride;
+                    unsigned char* vertex = (unsigned char*)&plyModel.pVertices[k];
+
+                    for (size_t i = 0; i < offsets.size(); i++) {
+                        if (offsets[i] < 0)
+                            continue;
+
+                        float value = (float)readValue(record + positions[i], element.properties[i].type);
+                        memcpy(vertex + offsets[i], &value, sizeof(float));
+                    }
+                }
+            }
+
+            p += stride * element.count;
+            hasVertices = true;
+        }
+        //----------- Faces ------------
+        else if (element.name == "face" && !hasFaces) {
+            int indexList = -1;
+            for (size_t i = 0; i < element.properties.size(); i++) {
+                const sPlyProperty& property = element.properties[i];
+                if (property.isList && (property.name == "vertex_indices" || property.name == "vertex_index")) {
+                    indexList = (int)i;
+                }
+            }
+            if (indexList == -1) {
+                std::cout << fileName << ": faces have no vertex indices." << std::endl;
+                return false;
+            }
+
+            plyModel.numberOfTriangles = element.count;
+            plyModel.numberOfIndices = element.count * 3;
+            plyModel.pIndices = plyModel.NewIndices(plyModel.numberOfIndices);
+
+            const sPlyProperty& indices = element.properties[indexList];
+            bool packed = element.properties.size() == 1 && indices.countType == PLY_UINT8
+                && (indices.type == PLY_INT32 || indices.type == PLY_UINT32);
+
+            bool triangles = true;
+
+            if (packed) {
+                if ((size_t)(end - p) / PACKED_TRIANGLE_SIZE < element.count) {
+                    std::cout << fileName << " is truncated." << std::endl;
+                    return false;
+                }
+
+                for (unsigned int k = 0; k < element.count && triangles; k++, p += PACKED_TRIANGLE_SIZE) {
+                    triangles = (p[0] == 3);
+                    memcpy(&plyModel.pIndices[k * 3], p + 1, 3 * sizeof(unsigned int));
+                }
+            }
+            else {
+                for (unsigned int k = 0; k < element.count && triangles; k++) {
+                    for (size_t i = 0; i < element.properties.size(); i++) {
+                        const sPlyProperty& property = element.properties[i];
+
+                        // Per face flags and such
+                        if (i != (size_t)indexList) {
+                            bool skipped = property.isList ? skipList(property, p, end)
+                                : (size_t)(end - p) >= typeSize(property.type);
+                            if (!skipped) {
+                                std::cout << fileName << " is truncated." << std::endl;
+                                return false;
+                            }
+                            if (!property.isList)
+                                p += typeSize(property.type);
+                            continue;
+                        }
+
+                        size_t countSize = typeSize(property.countType);
+                        size_t valueSize = typeSize(property.type);
+                        if ((size_t)(end - p) < countSize + 3 * valueSize) {
+                            std::cout << fileName << " is truncated." << std::endl;
+                            return false;
+                        }
+
+                        triangles = (readValue(p, property.countType) == 3);
+                        p += countSize;
+
+                        for (int v = 0; v < 3; v++, p += valueSize) {
+                            plyModel.pIndices[k * 3 + v] = (unsigned int)readValue(p, property.type);
+                        }
+                    }
+                }
+            }
+
+            if (!triangles) {
+                std::cout << fileName << ": only triangle faces are supported." << std::endl;
+                return false;
+            }
+
+            hasFaces = true;
+        }
+        // Elements we have no use for
+        else if (!skipElement(element, p, end)) {
+            std::cout << fileName << " is truncated." << std::endl;
+            return false;
+        }
+    }
 
-        plyFile >> triangleArray[count].triangleIndices[0];
-        plyFile >> triangleArray[count].triangleIndices[1];
-        plyFile >> triangleArray[count].triangleIndices[2];
-        int breakpoint = 1;
+    if (hasVertices && !indicesInRange(plyModel)) {
+        std::cout << fileName << " is damaged, a face uses a vertex that isn't there." << std::endl;
+        return false;
     }
-    plyFile.close();
 
-    plyModel.pVertices = new vertLayout[plyModel.numberOfVertices];
+    return hasVertices;
+}
 
-    for (unsigned int index = 0; index != plyModel.numberOfVertices; index++)
-    {
-        plyModel.pVertices[index].x = modelArray[index].x;
-        plyModel.pVertices[index].y = modelArray[index].y;
-        plyModel.pVertices[index].z = modelArray[index].z;
+bool PlyFileLoader::SaveBinary(const std::string& fileName, const sModelDrawInfo& model) {
 
-        plyModel.pVertices[index].r = modelArray[index].r;
-        plyModel.pVertices[index].g = modelArray[index].g;
-        plyModel.pVertices[index].b = modelArray[index].b;
+    std::ofstream plyFile(fileName.c_str(), std::ios::binary);
+    if (!plyFile.is_open()) {
+        return false;
+    }
 
-        plyModel.pVertices[index].nx = modelArray[index].nx;
-        plyModel.pVertices[index].ny = modelArray[index].ny;
-        plyModel.pVertices[index].nz = modelArray[index].nz;
+    unsigned int triangleCount = model.numberOfIndices / 3;
 
-        plyModel.pVertices[index].texture_u = modelArray[index].texture_u;
-        plyModel.pVertices[index].texture_v = modelArray[index].texture_v;
+    plyFile << "ply\n"
+            << "format binary_little_endian 1.0\n"
+            << "comment vertex properties in vertLayout order\n"
+            << "element vertex " << model.numberOfVertices << "\n";
+    for (size_t k = 0; k < VERTEX_PROPERTY_COUNT; k++) {
+        plyFile << "property float " << VERTEX_PROPERTIES[k] << "\n";
     }
+    plyFile << "element face " << triangleCount << "\n"
+            << "property list uchar uint vertex_indices\n"
+            << "end_header\n";
 
-    plyModel.numberOfIndices = plyModel.numberOfTriangles * 3;
-    plyModel.pIndices = new unsigned int[plyModel.numberOfIndices];
+    std::vector<unsigned char> vertices(model.numberOfVertices * PACKED_VERTEX_SIZE);
+    for (unsigned int k = 0; k < model.numberOfVertices; k++) {
+        memcpy(&vertices[k * PACKED_VERTEX_SIZE], &model.pVertices[k], PACKED_VERTEX_SIZE);
+    }
+    plyFile.write((const char*)vertices.data(), vertices.size());
 
-    unsigned int indexIndices = 0;
+    std::vector<unsigned char> faces(triangleCount * PACKED_TRIANGLE_SIZE);
+    for (unsigned int k = 0; k < triangleCount; k++) {
+        faces[k * PACKED_TRIANGLE_SIZE] = 3;
+        memcpy(&faces[k * PACKED_TRIANGLE_SIZE + 1], &model.pIndices[k * 3], 3 * sizeof(unsigned int));
+    }
+    plyFile.write((const char*)faces.data(), faces.size());
 
-    for (unsigned int triangleIndex = 0; triangleIndex != plyModel.numberOfTriangles; triangleIndex++)
-    {
-        plyModel.pIndices[indexIndices + 0] = triangleArray[triangleIndex].triangleIndices[0];
-        plyModel.pIndices[indexIndices + 1] = triangleArray[triangleIndex].triangleIndices[1];
-        plyModel.pIndices[indexIndices + 2] = triangleArray[triangleIndex].triangleIndices[2];
+    return plyFile.good();
+}
+
+bool PlyFileLoader::ConvertToBinary(const std::string& inputFile, const std::string& outputFile) {
+
+    sModelDrawInfo model;
+    if (!Parse(inputFile, model)) {
+        return false;
+    }
 
-        indexIndices += 3;
+    bool saved = SaveBinary(outputFile, model);
+    if (!saved) {
+        std::cout << "Could not write " << outputFile << std::endl;
     }
 
-    if (&plyModel != nullptr) {
+    model.ReleaseArrays();
+
+    return saved;
+}
+
+bool PlyFileLoader::loadAscii(const std::string& fileName, const char* data, size_t size,
+    const sPlyHeader& header, sModelDrawInfo& plyModel) {
+
+    const char* p = data + header.size;
+    const char* end = data + size;
 
-        plyModels.push_back(&plyModel);
+    bool hasVertices = false;
+    bool hasFaces = false;
+
+    // One write, lines of other loading threads don't end up in the middle
+    std::cout << ("Loading " + fileName + "\n");
+
+    for (size_t e = 0; e < header.elements.size(); e++) {
+        const sPlyElement& element = header.elements[e];
+
+        //----------- Vertices ------------
+        if (element.name == "vertex" && !hasVertices) {
+            if (recordSize(element) == 0) {
+                std::cout << fileName << ": vertices can't have list properties." << std::endl;
+                return false;
+            }
+
+            // Values are parsed straight into their place in vertLayout,
+            // attributes the file doesn't have stay 0
+            std::vector<int> offsets(element.properties.size());
+            for (size_t i = 0; i < element.properties.size(); i++) {
+                offsets[i] = vertexOffset(element.properties[i].name);
+            }
+
+            plyModel.numberOfVertices = element.count;
+            plyModel.pVertices = plyModel.NewVertices(element.count);
+
+            for (unsigned int k = 0; k < element.count; k++) {
+                unsigned char* vertex = (unsigned char*)&plyModel.pVertices[k];
+
+                for (size_t i = 0; i < offsets.size(); i++) {
+                    float value;
+                    if (!parseFloat(p, end, value)) {
+                        std::cout << fileName << ": vertex " << k << " is truncated or damaged." << std::endl;
+                        return false;
+                    }
+
+                    if (offsets[i] >= 0)
+                        memcpy(vertex + offsets[i], &value, sizeof(float));
+                }
+            }
+
+            hasVertices = true;
+        }
+        //----------- Faces ------------
+        else if (element.name == "face" && !hasFaces) {
+            int indexList = -1;
+            for (size_t i = 0; i < element.properties.size(); i++) {
+                const sPlyProperty& property = element.properties[i];
+                if (property.isList && (property.name == "vertex_indices" || property.name == "vertex_index")) {
+                    indexList = (int)i;
+                }
+            }
+            if (indexList == -1) {
+                std::cout << fileName << ": faces have no vertex indices." << std::endl;
+                return false;
+            }
+
+            plyModel.numberOfTriangles = element.count;
+            plyModel.numberOfIndices = element.count * 3;
+            plyModel.pIndices = plyModel.NewIndices(plyModel.numberOfIndices);
+
+            for (unsigned int k = 0; k < element.count; k++) {
+                for (size_t i = 0; i < element.properties.size(); i++) {
+                    bool parsed;
+
+                    if (i == (size_t)indexList) {
+                        unsigned int count;
+                        parsed = parseUnsigned(p, end, count);
+
+                        if (parsed && count != 3) {
+                            std::cout << fileName << ": only triangle faces are supported." << std::endl;
+                            return false;
+                        }
+
+                        unsigned int* triangle = &plyModel.pIndices[k * 3];
+                        parsed = parsed && parseUnsigned(p, end, triangle[0])
+                            && parseUnsigned(p, end, triangle[1])
+                            && parseUnsigned(p, end, triangle[2]);
+                    }
+                    else {
+                        parsed = skipAsciiProperty(element.properties[i], p, end);
+                    }
+
+                    if (!parsed) {
+                        std::cout << fileName << ": face " << k << " is truncated or damaged." << std::endl;
+                        return false;
+                    }
+                }
+            }
+
+            hasFaces = true;
+        }
+        // Elements we have no use for
+        else {
+            for (unsigned int k = 0; k < element.count; k++) {
+                for (size_t i = 0; i < element.properties.size(); i++) {
+                    if (!skipAsciiProperty(element.properties[i], p, end)) {
+                        std::cout << fileName << " is truncated." << std::endl;
+                        return false;
+                    }
+                }
+            }
+        }
     }
-    
-    delete[] modelArray;
-    delete[] triangleArray;
 
-    return plyModels.size() - 1;
-}
\ No newline at end of file
+    if (hasVertices && !indicesInRange(plyModel)) {
+        std::cout << fileName << " is damaged, a face uses a vertex that isn't there." << std::endl;
+        return false;
+    }
+
+    return hasVertices;
+}
@@ -5,23 +5,58 @@
 
 #include <string>
 #include <vector>
+#include <deque>
 
 #include "../cVAOManager/cVAOManager.h"
- 
+
+// Loads PLY models into the vertex and index arrays of a sModelDrawInfo.
+//
+// Files are memory mapped and the element and property declarations of
+// the header decide where every value goes, so properties can come in
+// any order and missing ones are left at 0. ASCII values are parsed with
+// std::from_chars straight into the final vertex and index arrays.
+// Binary little endian vertex and face blocks are copied in bulk:
+// when the vertex properties are floats in vertLayout order (the way
+// SaveBinary writes them) every vertex is a single copy, any other
+// property order or type is converted while copying.
 class PlyFileLoader {
 public:
 
-    struct vertexLayout {
+    enum ePlyFormat {
+        PLY_ASCII,
+        PLY_BINARY_LITTLE_ENDIAN,
+        PLY_BINARY_BIG_ENDIAN
+    };
+
+    enum ePlyType {
+        PLY_INT8,
+        PLY_UINT8,
+        PLY_INT16,
+        PLY_UINT16,
+        PLY_INT32,
+        PLY_UINT32,
+        PLY_FLOAT32,
+        PLY_FLOAT64,
+        PLY_INVALID
+    };
 
-        float x, y, z;
-        float nx, ny, nz;
-        float r, g, b, a;
-        float texture_u, texture_v;
+    struct sPlyProperty {
+        std::string name;
+        ePlyType type;          // type of the values (of the entries for lists)
+        ePlyType countType;     // lists only
+        bool isList;
     };
 
-    struct triangleLayout {
+    struct sPlyElement {
+        std::string name;
+        unsigned int count;
+        std::vector<sPlyProperty> properties;
+    };
 
-        unsigned int triangleIndices[3];
+    struct sPlyHeader {
+        ePlyFormat format;
+        std::vector<sPlyElement> elements;
+        size_t size;            // bytes up to and including "end_header\n"
     };
 
 	PlyFileLoader();
@@ -30,6 +65,38 @@ public:
 	sModelDrawInfo* GetPlyModelByID(unsigned int id);
 	int LoadModel(std::string fileName, sModelDrawInfo& plyModel);
 
+    // Same as LoadModel, without keeping track of the model. Several
+    // threads can load at once.
+    //
+    // Goes through the cooked mesh cache (see cMeshCache): when the file
+    // hasn't changed since it was cooked the arrays point straight into
+    // the mapped cooked file, otherwise the file is parsed and cooked.
+    // 'cookFlags' (cMeshCache::FLAG_*) say what's done to the model
+    // before it's cooked: welding and reordering for the vertex cache
+    // (cMeshOptimizer), and building LODs (cMeshSimplifier).
+    static bool Load(const std::string& fileName, sModelDrawInfo& plyModel, unsigned int cookFlags = 0);
+
+    // Parses the file without going through the cache, the arrays come
+    // from plyModel.pArena if it's set, or new[] (see NewVertices)
+    static bool Parse(const std::string& fileName, sModelDrawInfo& plyModel);
+
+    // Writes a model as binary little endian PLY, with the vertex
+    // properties in vertLayout order so loading it is a straight copy
+    static bool SaveBinary(const std::string& fileName, const sModelDrawInfo& model);
+
+    // One-shot conversion of a PLY file (usually ASCII) into binary
+    static bool ConvertToBinary(const std::string& inputFile, const std::string& outputFile);
+
+    // Reads the header of a PLY file, 'data' doesn't need to be null
+    // terminated
+    static bool ParseHeader(const char* data, size_t size, sPlyHeader& header);
+
 private:
-	std::vector<sModelDrawInfo*> plyModels;
+    static bool loadAscii(const std::string& fileName, const char* data, size_t size,
+        const sPlyHeader& header, sModelDrawInfo& plyModel);
+    static bool loadBinary(const std::string& fileName, const unsigned char* data, size_t size,
+        const sPlyHeader& header, sModelDrawInfo& plyModel);
+
+	// Copies, the models passed to LoadModel can go out of scope
+	std::deque<sModelDrawInfo> plyModels;
 };
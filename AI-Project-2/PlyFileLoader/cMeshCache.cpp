@@ -0,0 +1,195 @@
+#include "cMeshCache.h"
+
+#include "../cMappedFile/cMappedFile.h"
+
+#include <fstream>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstring>
+
+static const char FILE_MAGIC[4] = { 'M', 'E', 'S', 'H' };
+// LOD table, then the arrays
+static const size_t HEADER_SIZE = 92 + sModelDrawInfo::MAX_LODS * 12;
+
+// Cooked meshes in use, loads can come from several threads
+static std::mutex mappedMutex;
+static std::vector<std::unique_ptr<cMappedFile>> mappedFiles;
+
+// The cache is read by memcpy and pointers into the file, the same way
+// it was written, on little endian machines only
+static unsigned int readU32(const unsigned char* p)
+{
+	unsigned int value;
+	memcpy(&value, p, 4);
+	return value;
+}
+
+static uint64_t readU64(const unsigned char* p)
+{
+	uint64_t value;
+	memcpy(&value, p, 8);
+	return value;
+}
+
+template <typename T>
+static void write(std::vector<unsigned char>& out, T value)
+{
+	const unsigned char* bytes = (const unsigned char*)&value;
+	out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+std::string cMeshCache::CookedFileName(const std::string& plyFile) {
+
+	size_t dot = plyFile.find_last_of('.');
+	size_t slash = plyFile.find_last_of("/\\");
+
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+		return plyFile + ".mesh";
+
+	return plyFile.substr(0, dot) + ".mesh";
+}
+
+bool cMeshCache::Load(const std::string& plyFile, sModelDrawInfo& model, unsigned int flags) {
+
+	std::unique_ptr<cMappedFile> cooked(new cMappedFile());
+	if (!cooked->Open(CookedFileName(plyFile)))
+		return false;
+
+	const unsigned char* data = cooked->Data();
+	size_t size = cooked->Size();
+
+	if (size < HEADER_SIZE || memcmp(data, FILE_MAGIC, 4) != 0 || readU32(data + 4) != VERSION
+		|| readU32(data + 36) != sizeof(vertLayout) || readU32(data + 40) != flags)
+		return false;
+
+	uint64_t vertexCount = readU32(data + 24);
+	uint64_t indexCount = readU32(data + 28);
+
+	if (size != HEADER_SIZE + vertexCount * sizeof(vertLayout) + indexCount * sizeof(unsigned int))
+		return false;
+
+	unsigned int lodCount = readU32(data + 88);
+	if (readU32(data + 84) > indexCount || lodCount > sModelDrawInfo::MAX_LODS)
+		return false;
+
+	for (unsigned int k = 0; k < lodCount; k++) {
+		const unsigned char* lod = data + 92 + k * 12;
+		if ((uint64_t)readU32(lod) + readU32(lod + 4) > indexCount)
+			return false;
+	}
+
+	// Out of date once the model changes
+	cMappedFile source;
+	if (!source.Open(plyFile) || readU64(data + 8) != source.Size() || readU64(data + 16) != source.Checksum())
+		return false;
+
+	model.numberOfVertices = (unsigned int)vertexCount;
+	model.numberOfIndices = readU32(data + 84);
+	model.numberOfTriangles = readU32(data + 32);
+
+	model.numberOfLODs = lodCount;
+	for (unsigned int k = 0; k < lodCount; k++) {
+		const unsigned char* lod = data + 92 + k * 12;
+		model.lods[k].firstIndex = readU32(lod);
+		model.lods[k].numberOfIndices = readU32(lod + 4);
+		memcpy(&model.lods[k].error, lod + 8, 4);
+	}
+
+	float extents[10];
+	memcpy(extents, data + 44, sizeof(extents));
+	model.minX = extents[0];
+	model.minY = extents[1];
+	model.minZ = extents[2];
+	model.maxX = extents[3];
+	model.maxY = extents[4];
+	model.maxZ = extents[5];
+	model.extentX = extents[6];
+	model.extentY = extents[7];
+	model.extentZ = extents[8];
+	model.maxExtent = extents[9];
+	model.hasExtents = true;
+
+	// Both arrays are 4 byte aligned in the file, and the mapping is page aligned
+	model.pVertices = (vertLayout*)(data + HEADER_SIZE);
+	model.pIndices = (unsigned int*)(data + HEADER_SIZE + vertexCount * sizeof(vertLayout));
+	model.storage = sModelDrawInfo::MAPPED_STORAGE;
+
+	std::lock_guard<std::mutex> lock(mappedMutex);
+	mappedFiles.push_back(std::move(cooked));
+
+	return true;
+}
+
+bool cMeshCache::Save(const std::string& plyFile, const sModelDrawInfo& model, unsigned int flags) {
+
+	cMappedFile source;
+	if (!source.Open(plyFile))
+		return false;
+
+	std::vector<unsigned char> out;
+	out.reserve(HEADER_SIZE);
+
+	out.insert(out.end(), FILE_MAGIC, FILE_MAGIC + 4);
+	write<unsigned int>(out, VERSION);
+	write<uint64_t>(out, source.Size());
+	write<uint64_t>(out, source.Checksum());
+	write<unsigned int>(out, model.numberOfVertices);
+	write<unsigned int>(out, model.TotalIndices());
+	write<unsigned int>(out, model.numberOfTriangles);
+	write<unsigned int>(out, sizeof(vertLayout));
+	write<unsigned int>(out, flags);
+
+	write<float>(out, model.minX);
+	write<float>(out, model.minY);
+	write<float>(out, model.minZ);
+	write<float>(out, model.maxX);
+	write<float>(out, model.maxY);
+	write<float>(out, model.maxZ);
+	write<float>(out, model.extentX);
+	write<float>(out, model.extentY);
+	write<float>(out, model.extentZ);
+	write<float>(out, model.maxExtent);
+
+	write<unsigned int>(out, model.numberOfIndices);
+	write<unsigned int>(out, model.numberOfLODs);
+	for (unsigned int k = 0; k < sModelDrawInfo::MAX_LODS; k++) {
+		sModelLOD lod = {};
+		if (k < model.numberOfLODs)
+			lod = model.lods[k];
+
+		write<unsigned int>(out, lod.firstIndex);
+		write<unsigned int>(out, lod.numberOfIndices);
+		write<float>(out, lod.error);
+	}
+
+	std::ofstream file(CookedFileName(plyFile).c_str(), std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	file.write((const char*)out.data(), out.size());
+	file.write((const char*)model.pVertices, sizeof(vertLayout) * model.numberOfVertices);
+	file.write((const char*)model.pIndices, sizeof(unsigned int) * model.TotalIndices());
+
+	return file.good();
+}
+
+void cMeshCache::Release(const void* data) {
+
+	std::lock_guard<std::mutex> lock(mappedMutex);
+
+	for (size_t k = 0; k < mappedFiles.size(); k++) {
+		const unsigned char* start = mappedFiles[k]->Data();
+
+		if (data >= start && data < start + mappedFiles[k]->Size()) {
+			mappedFiles.erase(mappedFiles.begin() + k);
+			return;
+		}
+	}
+}
+
+void cMeshCache::ReleaseAll() {
+
+	std::lock_guard<std::mutex> lock(mappedMutex);
+	mappedFiles.clear();
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+// Cooked meshes: the vertex and index arrays of a model stored exactly
+// the way they are uploaded, next to the PLY file they were made from
+// ("bulb.ply" -> "bulb.mesh").
+//
+// Loading a cooked mesh is a memory mapping, the arrays are used right
+// where they are in the file and go to glBufferData from there. The
+// mappings stay open until ReleaseAll(); they are clean file pages the
+// OS can drop and read again at any time, unlike a heap copy.
+//
+// A cooked mesh is only used while the PLY file still has the size and
+// checksum it was cooked from, any change to the model cooks it again.
+// The same goes for a mesh cooked with other flags (optimised or not,
+// with or without LODs).
+//
+// Cooked file, values little endian:
+//     0   "MESH"
+//     4   u32 version
+//     8   u64 size of the PLY file, u64 checksum of the PLY file
+//     24  u32 vertices, u32 indices (all LODs), u32 triangles,
+//         u32 sizeof(vertLayout)
+//     40  u32 flags
+//     44  f32 minX, minY, minZ, maxX, maxY, maxZ,
+//         extentX, extentY, extentZ, maxExtent
+//     84  u32 indices of LOD 0, u32 number of LODs
+//     92  MAX_LODS x (u32 first index, u32 indices, f32 error)
+//     128 vertLayout vertices[vertices]    (MAX_LODS = 3)
+//         u32 indices[indices]
+
+#include <string>
+
+#include "../cVAOManager/cVAOManager.h"
+
+class cMeshCache {
+public:
+	static const unsigned int VERSION = 3;
+
+	// Flags a mesh is cooked with
+	static const unsigned int FLAG_OPTIMIZED = 1;	// went through cMeshOptimizer
+	static const unsigned int FLAG_LODS = 2;		// has levels from cMeshSimplifier
+
+	static std::string CookedFileName(const std::string& plyFile);
+
+	// Fills the model from the cooked copy of 'plyFile' if there is an
+	// up to date one cooked with 'flags'. The arrays point into the
+	// mapped file.
+	static bool Load(const std::string& plyFile, sModelDrawInfo& model, unsigned int flags);
+
+	// Cooks a model loaded from 'plyFile', extents and LODs included
+	static bool Save(const std::string& plyFile, const sModelDrawInfo& model, unsigned int flags);
+
+	// Unmaps the cooked mesh 'data' points into, once it's uploaded
+	static void Release(const void* data);
+
+	// Unmaps every cooked mesh, models loaded from the cache can't be
+	// read anymore afterwards (the GPU copies are unaffected)
+	static void ReleaseAll();
+};
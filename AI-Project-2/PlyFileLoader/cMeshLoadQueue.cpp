@@ -0,0 +1,131 @@
+#include "cMeshLoadQueue.h"
+
+#include "PlyFileLoader.h"
+#include "cMeshCache.h"
+
+#include <iostream>
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+cMeshLoadQueue::cMeshLoadQueue()
+	: nextJob(0)
+	, cookFlags(0)
+	, parseMilliseconds(0.0)
+	, totalMilliseconds(0.0)
+{
+}
+
+cMeshLoadQueue::~cMeshLoadQueue() {
+
+	// UploadAll never ran, let the workers finish the mesh they're on
+	nextJob = jobs.size();
+	join();
+}
+
+void cMeshLoadQueue::Add(const std::string& meshName, const std::string& fileName, bool keepCPUCopy) {
+
+	sMeshJob job;
+	job.meshName = meshName;
+	job.fileName = fileName;
+	job.drawInfo.keepCPUCopy = keepCPUCopy;
+	job.parsed = false;
+
+	jobs.push_back(job);
+}
+
+void cMeshLoadQueue::Start(int numThreads) {
+
+	if (numThreads <= 0)
+		numThreads = (int)std::thread::hardware_concurrency();
+	if (numThreads > (int)jobs.size())
+		numThreads = (int)jobs.size();
+	if (numThreads < 1)
+		numThreads = 1;
+
+	startTime = std::chrono::steady_clock::now();
+	nextJob = 0;
+
+	for (int t = 0; t < numThreads; t++) {
+		arenas.push_back(std::unique_ptr<cMeshArena>(new cMeshArena()));
+	}
+	for (int t = 0; t < numThreads; t++) {
+		workers.push_back(std::thread(&cMeshLoadQueue::worker, this, (size_t)t));
+	}
+}
+
+void cMeshLoadQueue::worker(size_t arenaIndex) {
+
+	for (;;) {
+		size_t index = nextJob++;
+		if (index >= jobs.size())
+			return;
+
+		sMeshJob& job = jobs[index];
+		job.drawInfo.pArena = arenas[arenaIndex].get();
+		job.parsed = PlyFileLoader::Load(job.fileName, job.drawInfo, cookFlags);
+
+		{
+			std::lock_guard<std::mutex> lock(finishedMutex);
+			finished.push_back(index);
+		}
+		finishedSignal.notify_one();
+	}
+}
+
+void cMeshLoadQueue::join() {
+
+	for (size_t t = 0; t < workers.size(); t++) {
+		workers[t].join();
+	}
+	workers.clear();
+}
+
+bool cMeshLoadQueue::UploadAll(cVAOManager* vaoManager, unsigned int shaderProgramID) {
+
+	bool allLoaded = true;
+
+	for (size_t uploaded = 0; uploaded < jobs.size(); uploaded++) {
+		size_t index;
+		{
+			std::unique_lock<std::mutex> lock(finishedMutex);
+			finishedSignal.wait(lock, [this] { return !finished.empty(); });
+
+			index = finished.front();
+			finished.pop_front();
+		}
+
+		if (uploaded + 1 == jobs.size())
+			parseMilliseconds = millisecondsSince(startTime);
+
+		sMeshJob& job = jobs[index];
+
+		if (!job.parsed) {
+			std::cerr << "Could not load " << job.fileName << std::endl;
+			allLoaded = false;
+			continue;
+		}
+
+		// Uploading lets go of the arrays, the mapping goes after it
+		const void* mapped = (job.drawInfo.storage == sModelDrawInfo::MAPPED_STORAGE) ? job.drawInfo.pVertices : nullptr;
+
+		if (!vaoManager->LoadModelIntoVAO(job.meshName, job.drawInfo, shaderProgramID)) {
+			std::cerr << "Could not load model into VAO" << std::endl;
+			allLoaded = false;
+		}
+
+		if (mapped) {
+			cMeshCache::Release(mapped);
+		}
+	}
+
+	join();
+
+	// Everything in them is on the GPU, or copied out by now
+	arenas.clear();
+	totalMilliseconds = millisecondsSince(startTime);
+
+	return allLoaded;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+// Loads a batch of meshes in parallel.
+//
+// Parsing the PLY files is plain CPU work, so every mesh is handed to a
+// pool of worker threads and parsed on its own. OpenGL calls have to stay
+// on the thread that owns the context, so the finished vertex and index
+// arrays are queued back to that thread, which uploads each one as soon
+// as it's ready (cVAOManager::LoadModelIntoVAO). Startup takes about as
+// long as the biggest mesh instead of the sum of all of them.
+//
+// Every worker parses into its own cMeshArena. Once a mesh is uploaded
+// its CPU arrays aren't needed (unless it was added with keepCPUCopy),
+// so the arenas and the cooked files the meshes were mapped from are all
+// let go of at the end of UploadAll.
+//
+//     cMeshLoadQueue queue;
+//     queue.Add("bulb", "bulb.ply");
+//     queue.Add("skybox_sphere", "skybox_sphere.ply");
+//     queue.Start(0);
+//     queue.UploadAll(VAOMan, shaderID);
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+#include "../cVAOManager/cVAOManager.h"
+#include "../cMeshArena/cMeshArena.h"
+
+class cMeshLoadQueue {
+public:
+	cMeshLoadQueue();
+	~cMeshLoadQueue();
+
+	// 'meshName' is the name the mesh is drawn by. 'keepCPUCopy' keeps
+	// its arrays after the upload (see sModelDrawInfo). All meshes have
+	// to be added before Start().
+	void Add(const std::string& meshName, const std::string& fileName, bool keepCPUCopy = false);
+
+	// What's done to every mesh when it's parsed and cooked, see
+	// PlyFileLoader::Load (nothing by default). Set before Start().
+	void SetCookFlags(unsigned int flags) { cookFlags = flags; }
+
+	// Starts parsing every mesh added so far on 'numThreads' workers
+	// (0 = one per core, never more than there are meshes)
+	void Start(int numThreads);
+
+	// Has to run on the GL thread. Uploads the meshes in the order they
+	// finish parsing and returns once all of them are done. False if any
+	// of them couldn't be loaded.
+	bool UploadAll(cVAOManager* vaoManager, unsigned int shaderProgramID);
+
+	// Time from Start() to the last parsed mesh, and to the last upload
+	double ParseMilliseconds() const { return parseMilliseconds; }
+	double TotalMilliseconds() const { return totalMilliseconds; }
+
+private:
+	struct sMeshJob {
+		std::string meshName;
+		std::string fileName;
+		sModelDrawInfo drawInfo;
+		bool parsed;
+	};
+
+	// Not copyable, the workers point at the jobs
+	cMeshLoadQueue(const cMeshLoadQueue&);
+	cMeshLoadQueue& operator=(const cMeshLoadQueue&);
+
+	void worker(size_t arenaIndex);
+	void join();
+
+	std::vector<sMeshJob> jobs;
+	std::vector<std::thread> workers;
+	// One per worker
+	std::vector<std::unique_ptr<cMeshArena>> arenas;
+
+	// Next job a worker picks up
+	std::atomic<size_t> nextJob;
+	unsigned int cookFlags;
+
+	// Parsed jobs waiting for the GL thread
+	std::mutex finishedMutex;
+	std::condition_variable finishedSignal;
+	std::deque<size_t> finished;
+
+	std::chrono::steady_clock::time_point startTime;
+	double parseMilliseconds;
+	double totalMilliseconds;
+};
@@ -0,0 +1,133 @@
+#include "cInstancedMesh.h"
+#include "../OpenGL.h"
+
+#include <cstddef>
+
+cInstancedMesh::cInstancedMesh(const std::string& meshName)
+	: meshName(meshName)
+	, numberOfVisible(0)
+	, isDirty(false)
+	, meshHandle(cVAOManager::INVALID_MESH_HANDLE)
+	, vaoID(0)
+	, instanceBufferID(0)
+	, instanceCapacity(0)
+	, builtOnBufferID(0)
+{
+}
+
+cInstancedMesh::~cInstancedMesh() {
+
+	// The context may be gone by now, only delete what was made
+	if (vaoID != 0) {
+		glDeleteVertexArrays(1, &vaoID);
+	}
+	if (instanceBufferID != 0) {
+		glDeleteBuffers(1, &instanceBufferID);
+	}
+}
+
+unsigned int cInstancedMesh::AddInstance(const glm::vec3& position, float scale, const glm::vec4& colour) {
+
+	sMeshInstance instance;
+	instance.positionScale = glm::vec4(position, scale);
+	instance.colour = colour;
+
+	instances.push_back(instance);
+	visible.push_back(true);
+	numberOfVisible++;
+	isDirty = true;
+
+	return (unsigned int)instances.size() - 1;
+}
+
+void cInstancedMesh::SetVisible(unsigned int index, bool isVisible) {
+
+	if (index >= instances.size() || visible[index] == isVisible)
+		return;
+
+	visible[index] = isVisible;
+	numberOfVisible += isVisible ? 1 : -1;
+	isDirty = true;
+}
+
+void cInstancedMesh::Clear() {
+
+	instances.clear();
+	visible.clear();
+	numberOfVisible = 0;
+	isDirty = true;
+}
+
+bool cInstancedMesh::Prepare(cVAOManager* VAOManager, unsigned int shaderProgramID) {
+
+	if (meshHandle == cVAOManager::INVALID_MESH_HANDLE) {
+		meshHandle = VAOManager->GetMeshHandle(meshName);
+
+		if (meshHandle == cVAOManager::INVALID_MESH_HANDLE)
+			return false;
+	}
+
+	if (instanceBufferID == 0) {
+		glGenBuffers(1, &instanceBufferID);
+	}
+
+	// Only the visible ones go up, so the draw doesn't need to skip any
+	if (isDirty) {
+		std::vector<sMeshInstance> packed;
+		packed.reserve(numberOfVisible);
+
+		for (size_t k = 0; k < instances.size(); k++) {
+			if (visible[k])
+				packed.push_back(instances[k]);
+		}
+
+		glBindBuffer(GL_ARRAY_BUFFER, instanceBufferID);
+
+		if (numberOfVisible > instanceCapacity) {
+			// Walls get added one at a time while editing, leave some room
+			instanceCapacity = numberOfVisible + numberOfVisible / 2;
+			glBufferData(GL_ARRAY_BUFFER, sizeof(sMeshInstance) * instanceCapacity, NULL, GL_DYNAMIC_DRAW);
+		}
+
+		if (!packed.empty()) {
+			glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(sMeshInstance) * packed.size(), packed.data());
+		}
+
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		isDirty = false;
+	}
+
+	// The mesh's own attributes come from its buffers, which change if
+	// they're the shared ones and they had to grow
+	const sModelDrawInfo* drawInfo = VAOManager->GetDrawInfo(meshHandle);
+
+	if (vaoID == 0 || builtOnBufferID != drawInfo->VertexBufferID) {
+		if (vaoID != 0) {
+			glDeleteVertexArrays(1, &vaoID);
+		}
+
+		vaoID = VAOManager->CreateModelVAO(meshHandle, shaderProgramID);
+		builtOnBufferID = drawInfo->VertexBufferID;
+
+		GLint vInstancePositionScaleLocation = glGetAttribLocation(shaderProgramID, "vInstancePositionScale");
+		GLint vInstanceColourLocation = glGetAttribLocation(shaderProgramID, "vInstanceColour");
+
+		glBindBuffer(GL_ARRAY_BUFFER, instanceBufferID);
+
+		glEnableVertexAttribArray(vInstancePositionScaleLocation);
+		glVertexAttribPointer(vInstancePositionScaleLocation, 4, GL_FLOAT, GL_FALSE,
+			sizeof(sMeshInstance), (void*)offsetof(sMeshInstance, positionScale));
+		glVertexAttribDivisor(vInstancePositionScaleLocation, 1);
+
+		glEnableVertexAttribArray(vInstanceColourLocation);
+		glVertexAttribPointer(vInstanceColourLocation, 4, GL_FLOAT, GL_FALSE,
+			sizeof(sMeshInstance), (void*)offsetof(sMeshInstance, colour));
+		glVertexAttribDivisor(vInstanceColourLocation, 1);
+
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	}
+
+	return true;
+}
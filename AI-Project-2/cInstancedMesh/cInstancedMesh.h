@@ -0,0 +1,74 @@
+#pragma once
+
+// Many copies of one mesh drawn with a single instanced draw call.
+//
+// Every copy is a position, a uniform scale and a colour, kept in one
+// per-instance vertex buffer next to the mesh's own vertices. The vertex
+// shader places and colours each copy (bIsInstanced), so there's no
+// cMeshInfo, no model matrix and no uniforms per copy. Meant for the maze
+// walls: thousands of unrotated cubes that only differ in where they are
+// and what colour they have.
+//
+//     cInstancedMesh walls("wall_cube");
+//     walls.AddInstance(position, 75.f, glm::vec4(0.f, 0.f, 0.f, 1.f));
+//     ...
+//     DrawInstancedMesh(&walls, shaderID, VAOMan, modelULoc, modelInverseULoc);
+
+#include <string>
+#include <vector>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include "../cVAOManager/cVAOManager.h"
+
+// One copy, as the vertex shader gets it
+struct sMeshInstance
+{
+	glm::vec4 positionScale;	// xyz where it is, w its scale
+	glm::vec4 colour;			// like cMeshInfo::RGBAColour
+};
+
+class cInstancedMesh {
+public:
+	cInstancedMesh(const std::string& meshName);
+	~cInstancedMesh();
+
+	std::string meshName;
+
+	// Returns the copy's index, which it keeps
+	unsigned int AddInstance(const glm::vec3& position, float scale, const glm::vec4& colour);
+
+	// Hidden copies aren't uploaded
+	void SetVisible(unsigned int index, bool isVisible);
+	void Clear();
+
+	unsigned int NumberOfInstances() const { return (unsigned int)instances.size(); }
+	unsigned int NumberOfVisible() const { return numberOfVisible; }
+
+	// Has to run on the GL thread before drawing. Uploads the visible
+	// copies if any changed, and (re)builds the VAO when the mesh's
+	// buffers aren't the ones it was built on. False if the mesh isn't
+	// loaded.
+	bool Prepare(cVAOManager* VAOManager, unsigned int shaderProgramID);
+
+	// Valid after Prepare
+	unsigned int VAO_ID() const { return vaoID; }
+	unsigned int MeshHandle() const { return meshHandle; }
+
+private:
+	// Not copyable, it owns GL objects
+	cInstancedMesh(const cInstancedMesh&);
+	cInstancedMesh& operator=(const cInstancedMesh&);
+
+	std::vector<sMeshInstance> instances;
+	std::vector<bool> visible;
+	unsigned int numberOfVisible;
+	bool isDirty;
+
+	unsigned int meshHandle;
+	unsigned int vaoID;
+	unsigned int instanceBufferID;
+	unsigned int instanceCapacity;
+	// The mesh vertex buffer the VAO was built on
+	unsigned int builtOnBufferID;
+};
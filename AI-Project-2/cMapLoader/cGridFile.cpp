@@ -0,0 +1,349 @@
+#include "cGridFile.h"
+
+#include "cMapLoader.h"
+#include "../cMappedFile/cMappedFile.h"
+
+#include <fstream>
+#include <cstring>
+
+static const char FILE_MAGIC[4] = { 'G', 'R', 'I', 'D' };
+
+static const size_t HEADER_SIZE = 56;
+static const size_t SECTION_ENTRY_SIZE = 24;
+
+// Values are little endian and not aligned
+static unsigned int readU32(const unsigned char* p)
+{
+	return (unsigned int)p[0] | ((unsigned int)p[1] << 8)
+		| ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+static int readS32(const unsigned char* p)
+{
+	return (int)readU32(p);
+}
+
+static uint64_t readU64(const unsigned char* p)
+{
+	return (uint64_t)readU32(p) | ((uint64_t)readU32(p + 4) << 32);
+}
+
+static void writeU32(std::vector<unsigned char>& out, unsigned int value)
+{
+	for (int k = 0; k < 4; k++) {
+		out.push_back((unsigned char)(value >> (8 * k)));
+	}
+}
+
+static void writeU64(std::vector<unsigned char>& out, uint64_t value)
+{
+	writeU32(out, (unsigned int)value);
+	writeU32(out, (unsigned int)(value >> 32));
+}
+
+static void patchU64(std::vector<unsigned char>& out, size_t offset, uint64_t value)
+{
+	for (int k = 0; k < 8; k++) {
+		out[offset + k] = (unsigned char)(value >> (8 * k));
+	}
+}
+
+cGridFile::cGridFile()
+	: hasClearance(false)
+	, hasSymmetry(false)
+{
+}
+
+cGridFile::~cGridFile() {
+
+}
+
+std::string cGridFile::getLastError(void) {
+
+	return lastError;
+}
+
+bool cGridFile::Save(const std::string& fileName, const std::string& sourceFile,
+	const cPathGrid& grid, Pair start, Pair goal,
+	const std::vector<sSpecialCell>& specialCells,
+	const cRectangularSymmetry* symmetry) {
+
+	lastError = "";
+
+	cMappedFile source;
+	if (!source.Open(sourceFile)) {
+		lastError = "Could not open " + sourceFile;
+		return false;
+	}
+
+	const cGridLayout& layout = grid.GetLayout();
+	size_t cellCount = layout.Size();
+
+	int sectionCount = 3 + (symmetry != nullptr ? 1 : 0);
+
+	//----------- Header ------------
+	std::vector<unsigned char> out;
+	out.insert(out.end(), FILE_MAGIC, FILE_MAGIC + 4);
+	writeU32(out, VERSION);
+	writeU32(out, (unsigned int)grid.Rows());
+	writeU32(out, (unsigned int)grid.Cols());
+	writeU32(out, (unsigned int)layout.Layout());
+	writeU32(out, (unsigned int)start.first);
+	writeU32(out, (unsigned int)start.second);
+	writeU32(out, (unsigned int)goal.first);
+	writeU32(out, (unsigned int)goal.second);
+	writeU32(out, (unsigned int)sectionCount);
+	writeU64(out, source.Size());
+	writeU64(out, source.Checksum());
+
+	// Filled in as the sections are written
+	size_t table = out.size();
+	out.resize(table + sectionCount * SECTION_ENTRY_SIZE, 0);
+
+	int section = 0;
+	auto beginSection = [&](eSection id) {
+		out.resize((out.size() + 7) & ~(size_t)7, 0);
+
+		size_t entry = table + section * SECTION_ENTRY_SIZE;
+		patchU64(out, entry, (uint64_t)id);	// id and the zero after it
+		patchU64(out, entry + 8, out.size());
+		return out.size();
+	};
+	auto endSection = [&](size_t begin) {
+		patchU64(out, table + section * SECTION_ENTRY_SIZE + 16, out.size() - begin);
+		section++;
+	};
+
+	//----------- Sections ------------
+	size_t begin = beginSection(WALKABLE_SECTION);
+	const unsigned char* cells = grid.CellData();
+	for (size_t k = 0; k < cellCount; k += 64) {
+		uint64_t word = 0;
+		for (size_t b = 0; b < 64 && k + b < cellCount; b++) {
+			word |= (uint64_t)(cells[k + b] != 0) << b;
+		}
+		writeU64(out, word);
+	}
+	endSection(begin);
+
+	begin = beginSection(CLEARANCE_SECTION);
+	out.insert(out.end(), grid.ClearanceData(), grid.ClearanceData() + cellCount);
+	endSection(begin);
+
+	begin = beginSection(SPECIAL_CELLS_SECTION);
+	for (int k = 0; k < specialCells.size(); k++) {
+		writeU32(out, (unsigned int)specialCells[k].row);
+		writeU32(out, (unsigned int)specialCells[k].col);
+		writeU32(out, specialCells[k].cell);
+	}
+	endSection(begin);
+
+	if (symmetry != nullptr) {
+		begin = beginSection(RECTANGLES_SECTION);
+		const std::vector<sRectangle>& rectangles = symmetry->Rectangles();
+		for (int k = 0; k < rectangles.size(); k++) {
+			if (cRectangularSymmetry::IsEmpty(rectangles[k]))
+				continue;
+
+			writeU32(out, (unsigned int)rectangles[k].top);
+			writeU32(out, (unsigned int)rectangles[k].left);
+			writeU32(out, (unsigned int)rectangles[k].bottom);
+			writeU32(out, (unsigned int)rectangles[k].right);
+		}
+		endSection(begin);
+	}
+
+	std::ofstream file(fileName.c_str(), std::ios::binary);
+	if (!file.is_open()) {
+		lastError = "Could not create " + fileName;
+		return false;
+	}
+
+	file.write((const char*)out.data(), out.size());
+	if (!file.good()) {
+		lastError = "Could not write " + fileName;
+		return false;
+	}
+
+	return true;
+}
+
+bool cGridFile::Load(const std::string& fileName, const std::string& sourceFile,
+	cPathGrid& grid, eGridLayout layout, Pair& start, Pair& goal,
+	cRectangularSymmetry* symmetry) {
+
+	hasClearance = false;
+	hasSymmetry = false;
+	specialCells.clear();
+	starts.clear();
+	goals.clear();
+	lastError = "";
+
+	cMappedFile file;
+	if (!file.Open(fileName)) {
+		lastError = "Could not open " + fileName;
+		return false;
+	}
+
+	const unsigned char* data = file.Data();
+	size_t fileSize = file.Size();
+
+	//----------- Header ------------
+	if (fileSize < HEADER_SIZE || memcmp(data, FILE_MAGIC, 4) != 0) {
+		lastError = fileName + " is not a grid file";
+		return false;
+	}
+
+	if (readU32(data + 4) != VERSION) {
+		lastError = fileName + " is version " + std::to_string(readU32(data + 4))
+			+ ", expected " + std::to_string(VERSION);
+		return false;
+	}
+
+	int rows = readS32(data + 8);
+	int cols = readS32(data + 12);
+	unsigned int savedLayout = readU32(data + 16);
+	unsigned int sectionCount = readU32(data + 36);
+
+	if (rows <= 0 || cols <= 0 || savedLayout > MORTON_LAYOUT
+		|| sectionCount > (fileSize - HEADER_SIZE) / SECTION_ENTRY_SIZE) {
+		lastError = fileName + " has a broken header";
+		return false;
+	}
+
+	// Out of date once the map it was made from changes
+	cMappedFile source;
+	if (!source.Open(sourceFile)) {
+		lastError = "Could not open " + sourceFile;
+		return false;
+	}
+
+	if (readU64(data + 40) != source.Size() || readU64(data + 48) != source.Checksum()) {
+		lastError = fileName + " was made from another version of " + sourceFile;
+		return false;
+	}
+
+	//----------- Sections ------------
+	const unsigned char* sections[SPECIAL_CELLS_SECTION + 1] = {};
+	size_t sectionSizes[SPECIAL_CELLS_SECTION + 1] = {};
+
+	for (unsigned int k = 0; k < sectionCount; k++) {
+		const unsigned char* entry = data + HEADER_SIZE + k * SECTION_ENTRY_SIZE;
+		unsigned int id = readU32(entry);
+		uint64_t offset = readU64(entry + 8);
+		uint64_t size = readU64(entry + 16);
+
+		if (offset > fileSize || size > fileSize - offset) {
+			lastError = fileName + " is truncated";
+			return false;
+		}
+
+		// Sections added by later versions
+		if (id < WALKABLE_SECTION || id > SPECIAL_CELLS_SECTION)
+			continue;
+
+		sections[id] = data + offset;
+		sectionSizes[id] = (size_t)size;
+	}
+
+	size_t cellCount = cGridLayout(rows, cols, (eGridLayout)savedLayout).Size();
+
+	if (sections[WALKABLE_SECTION] == nullptr
+		|| sectionSizes[WALKABLE_SECTION] != ((cellCount + 63) / 64) * 8) {
+		lastError = fileName + " has no walkability section";
+		return false;
+	}
+
+	grid.Resize(rows, cols, (eGridLayout)savedLayout);
+
+	// Cells are stored in the grid layout, so they expand in order
+	const unsigned char* bits = sections[WALKABLE_SECTION];
+	unsigned char* cells = grid.CellData();
+	for (size_t k = 0; k < cellCount; k += 64) {
+		uint64_t word = readU64(bits + k / 8);
+		for (size_t b = 0; b < 64 && k + b < cellCount; b++) {
+			cells[k + b] = (unsigned char)((word >> b) & 1);
+		}
+	}
+
+	if (sections[CLEARANCE_SECTION] != nullptr && sectionSizes[CLEARANCE_SECTION] == cellCount) {
+		memcpy(grid.ClearanceData(), sections[CLEARANCE_SECTION], cellCount);
+		hasClearance = true;
+	}
+
+	if (sections[SPECIAL_CELLS_SECTION] != nullptr) {
+		const unsigned char* p = sections[SPECIAL_CELLS_SECTION];
+		size_t count = sectionSizes[SPECIAL_CELLS_SECTION] / 12;
+
+		specialCells.resize(count);
+		for (size_t k = 0; k < count; k++, p += 12) {
+			specialCells[k].row = readS32(p);
+			specialCells[k].col = readS32(p + 4);
+			specialCells[k].cell = (unsigned char)readU32(p + 8);
+		}
+
+		cMapLoader::CollectStartsAndGoals(specialCells, starts, goals);
+	}
+
+	start = std::make_pair(readS32(data + 20), readS32(data + 24));
+	goal = std::make_pair(readS32(data + 28), readS32(data + 32));
+
+	// Every cell the caller will index the grid with has to be on it,
+	// a map without a start or a goal saves them as (-1, -1)
+	bool cellsInside = (start == std::make_pair(-1, -1) || grid.IsInside(start.first, start.second))
+		&& (goal == std::make_pair(-1, -1) || grid.IsInside(goal.first, goal.second));
+
+	for (size_t k = 0; k < specialCells.size() && cellsInside; k++) {
+		cellsInside = grid.IsInside(specialCells[k].row, specialCells[k].col);
+	}
+
+	if (!cellsInside) {
+		specialCells.clear();
+		starts.clear();
+		goals.clear();
+		lastError = fileName + " is damaged, it has a cell that isn't on the map";
+		return false;
+	}
+
+	if (grid.GetLayout().Layout() != layout)
+		grid.ChangeLayout(layout);
+
+	// The rectangles are checked against the grid, a damaged section
+	// only means the decomposition has to be rebuilt
+	if (symmetry != nullptr && sections[RECTANGLES_SECTION] != nullptr) {
+		const unsigned char* p = sections[RECTANGLES_SECTION];
+		std::vector<sRectangle> rectangles(sectionSizes[RECTANGLES_SECTION] / 16);
+
+		for (size_t k = 0; k < rectangles.size(); k++, p += 16) {
+			rectangles[k].top = readS32(p);
+			rectangles[k].left = readS32(p + 4);
+			rectangles[k].bottom = readS32(p + 8);
+			rectangles[k].right = readS32(p + 12);
+		}
+
+		hasSymmetry = symmetry->SetRectangles(rectangles, grid);
+	}
+
+	return true;
+}
+
+bool cGridFile::Convert(const std::string& bmpFile, const std::string& gridFile, eGridLayout layout) {
+
+	lastError = "";
+
+	cMapLoader mapLoader;
+	cPathGrid grid;
+	Pair start, goal;
+
+	if (!mapLoader.LoadBMP(bmpFile, grid, layout, start, goal)) {
+		lastError = mapLoader.getLastError();
+		return false;
+	}
+
+	grid.UpdateClearance();
+
+	cRectangularSymmetry symmetry;
+	symmetry.Build(grid);
+
+	return Save(gridFile, bmpFile, grid, start, goal, mapLoader.GetSpecialCells(), &symmetry);
+}
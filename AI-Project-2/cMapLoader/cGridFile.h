@@ -0,0 +1,86 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "../A-Star Algorithm/cPathGrid.h"
+#include "../A-Star Algorithm/cRectangularSymmetry.h"
+#include "cMapPalette.h"
+
+// Precompiled map (.grid)
+//
+// Holds everything startup would otherwise rebuild from the BMP: the
+// walkability bitboard, start and goal, and optional sections with the
+// precomputed data (clearance, symmetry rectangles, special cells).
+// The file is memory mapped and the sections are copied straight into
+// the grid in its storage layout, nothing is recomputed.
+//
+// The file remembers the size and checksum of the BMP it was made from
+// and is rejected once the BMP changes, so it can't go stale.
+//
+// Layout, all values little endian:
+//     0   "GRID"
+//     4   u32 version
+//     8   u32 rows, u32 cols, u32 grid layout
+//     20  i32 start row, start col, goal row, goal col
+//     36  u32 section count
+//     40  u64 BMP size, u64 BMP checksum
+//     56  section table, per section: u32 id, u32 0, u64 offset, u64 size
+// Sections start on 8 byte boundaries. Unknown section ids are skipped,
+// so new kinds of precomputed data can be added without breaking older
+// files.
+class cGridFile {
+public:
+	static const unsigned int VERSION = 1;
+
+	enum eSection
+	{
+		WALKABLE_SECTION = 1,	// 1 bit per cell in layout order, u64 words
+		CLEARANCE_SECTION,		// 1 byte per cell in layout order
+		RECTANGLES_SECTION,		// i32 top, left, bottom, right per rectangle
+		SPECIAL_CELLS_SECTION	// i32 row, i32 col, u32 cell type per cell
+	};
+
+	cGridFile();
+	~cGridFile();
+
+	// Saves the grid as it is, call UpdateClearance() first.
+	// 'symmetry' may be null to leave the rectangles out.
+	bool Save(const std::string& fileName, const std::string& sourceFile,
+		const cPathGrid& grid, Pair start, Pair goal,
+		const std::vector<sSpecialCell>& specialCells,
+		const cRectangularSymmetry* symmetry);
+
+	// Fails if the file is missing, damaged, of another version, or
+	// wasn't made from the current contents of 'sourceFile'. The grid
+	// is converted to 'layout' if it was saved in another one.
+	// 'symmetry' may be null.
+	bool Load(const std::string& fileName, const std::string& sourceFile,
+		cPathGrid& grid, eGridLayout layout, Pair& start, Pair& goal,
+		cRectangularSymmetry* symmetry);
+
+	// Loads a BMP map, precomputes everything and saves it as a .grid
+	bool Convert(const std::string& bmpFile, const std::string& gridFile, eGridLayout layout);
+
+	// Optional sections found by the last Load(), whatever is missing
+	// has to be rebuilt by the caller
+	bool HasClearance() const { return hasClearance; }
+	bool HasSymmetry() const { return hasSymmetry; }
+
+	const std::vector<sSpecialCell>& GetSpecialCells() const { return specialCells; }
+
+	// Every start and goal cell of the last Load(), bottom row first
+	const std::vector<Pair>& GetStarts() const { return starts; }
+	const std::vector<Pair>& GetGoals() const { return goals; }
+
+	std::string getLastError(void);
+
+private:
+	bool hasClearance;
+	bool hasSymmetry;
+	std::vector<sSpecialCell> specialCells;
+	std::vector<Pair> starts;
+	std::vector<Pair> goals;
+
+	std::string lastError;
+};
@@ -0,0 +1,219 @@
+#include "cMapLoader.h"
+
+#include "../cMappedFile/cMappedFile.h"
+
+#include <vector>
+#include <algorithm>
+
+// BMP compression types we can read
+static const unsigned int BI_RGB_COMPRESSION = 0;
+static const unsigned int BI_BITFIELDS_COMPRESSION = 3;
+
+static const size_t FILE_HEADER_SIZE = 14;
+static const size_t INFO_HEADER_SIZE = 40;
+
+// BMP fields are little endian and not aligned
+static unsigned int readU16(const unsigned char* p)
+{
+	return (unsigned int)p[0] | ((unsigned int)p[1] << 8);
+}
+
+static unsigned int readU32(const unsigned char* p)
+{
+	return (unsigned int)p[0] | ((unsigned int)p[1] << 8)
+		| ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+static int readS32(const unsigned char* p)
+{
+	return (int)readU32(p);
+}
+
+// Sets the grid cells of the bits set in a row mask
+static void applyRowMask(cPathGrid& grid, int row, int width, const uint64_t* mask)
+{
+	for (size_t w = 0; w < cMapPalette::MaskWords(width); w++) {
+		uint64_t bits = mask[w];
+
+		for (int col = (int)(w * 64); bits != 0; col++, bits >>= 1) {
+			if (bits & 1)
+				grid.SetWalkable(row, col, true);
+		}
+	}
+}
+
+cMapLoader::cMapLoader() {
+
+}
+
+cMapLoader::~cMapLoader() {
+
+}
+
+std::string cMapLoader::getLastError(void) {
+
+	return lastError;
+}
+
+bool cMapLoader::LoadBMP(const std::string& fileName, cPathGrid& grid, eGridLayout layout,
+	Pair& start, Pair& goal) {
+
+	start = std::make_pair(-1, -1);
+	goal = std::make_pair(-1, -1);
+	specialCells.clear();
+	starts.clear();
+	goals.clear();
+	lastError = "";
+
+	cMappedFile file;
+	if (!file.Open(fileName)) {
+		lastError = "Could not open " + fileName;
+		return false;
+	}
+
+	const unsigned char* data = file.Data();
+	size_t fileSize = file.Size();
+
+	//----------- Headers ------------
+	if (fileSize < FILE_HEADER_SIZE + INFO_HEADER_SIZE || data[0] != 'B' || data[1] != 'M') {
+		lastError = fileName + " is not a BMP file";
+		return false;
+	}
+
+	unsigned int dataOffset = readU32(data + 10);
+	unsigned int infoSize = readU32(data + 14);
+
+	// BITMAPINFOHEADER or one of the later versions that extend it
+	if (infoSize < INFO_HEADER_SIZE || FILE_HEADER_SIZE + infoSize > fileSize) {
+		lastError = fileName + " has an unsupported BMP header";
+		return false;
+	}
+
+	int width = readS32(data + 18);
+	int height = readS32(data + 22);
+	unsigned int bitCount = readU16(data + 28);
+	unsigned int compression = readU32(data + 30);
+	unsigned int coloursUsed = readU32(data + 46);
+
+	// Negative height means the rows are stored top to bottom
+	bool topDown = height < 0;
+	if (topDown)
+		height = -height;
+
+	if (width <= 0 || height <= 0) {
+		lastError = fileName + " has no pixels";
+		return false;
+	}
+
+	if (bitCount != 1 && bitCount != 4 && bitCount != 8 && bitCount != 24 && bitCount != 32) {
+		lastError = fileName + ": " + std::to_string(bitCount) + " bit BMPs are not supported";
+		return false;
+	}
+
+	// 32 bit images may come with channel masks, only plain BGRA is read
+	if (compression == BI_BITFIELDS_COMPRESSION && bitCount == 32) {
+		size_t masks = FILE_HEADER_SIZE + INFO_HEADER_SIZE;
+		if (masks + 12 > fileSize
+			|| readU32(data + masks) != 0x00ff0000
+			|| readU32(data + masks + 4) != 0x0000ff00
+			|| readU32(data + masks + 8) != 0x000000ff) {
+			lastError = fileName + " uses unsupported channel masks";
+			return false;
+		}
+	}
+	else if (compression != BI_RGB_COMPRESSION) {
+		lastError = fileName + " is compressed, only uncompressed BMPs are supported";
+		return false;
+	}
+
+	// Rows are padded to a multiple of 4 bytes
+	size_t stride = (((size_t)width * bitCount + 31) / 32) * 4;
+
+	if (dataOffset > fileSize || stride * (size_t)height > fileSize - dataOffset) {
+		lastError = fileName + " is truncated";
+		return false;
+	}
+
+	//----------- Palette ------------
+	// Look the palette entries up once, instead of every pixel
+	std::vector<sPaletteEntry> paletteCells;
+	if (bitCount <= 8) {
+		size_t entries = (coloursUsed != 0) ? coloursUsed : ((size_t)1 << bitCount);
+		size_t paletteOffset = FILE_HEADER_SIZE + infoSize;
+
+		if (paletteOffset + entries * 4 > dataOffset) {
+			lastError = fileName + " has a broken palette";
+			return false;
+		}
+
+		// Indices past the end of the palette read as walls
+		sPaletteEntry wall = { 0, WALL_CELL, false };
+		paletteCells.assign((size_t)1 << bitCount, wall);
+
+		for (size_t k = 0; k < entries && k < paletteCells.size(); k++) {
+			const unsigned char* entry = data + paletteOffset + k * 4;
+			paletteCells[k] = palette.Lookup(cMapPalette::ColourKey(entry[0], entry[1], entry[2]));
+		}
+	}
+
+	//----------- Pixels ------------
+	grid.Resize(height, width, layout);
+
+	size_t bytesPerPixel = bitCount / 8;
+	std::vector<uint64_t> mask(cMapPalette::MaskWords(width));
+
+	for (int i = 0; i < height; i++) {
+		// Grid row 0 is the bottom row of the image
+		int storedRow = topDown ? (height - 1 - i) : i;
+		const unsigned char* row = data + dataOffset + stride * storedRow;
+
+		if (bitCount > 8) {
+			// The vector loop may read ahead, up to the end of the file
+			size_t rowBytes = fileSize - (dataOffset + stride * storedRow);
+			palette.ClassifyRow(row, width, (int)bytesPerPixel, rowBytes, i, mask.data(), specialCells);
+		}
+		else {
+			std::fill(mask.begin(), mask.end(), 0);
+
+			for (int j = 0; j < width; j++) {
+				size_t bit = (size_t)j * bitCount;
+				unsigned int index = (row[bit >> 3] >> (8 - bitCount - (bit & 7))) & ((1u << bitCount) - 1);
+				const sPaletteEntry& entry = paletteCells[index];
+
+				if (entry.walkable)
+					mask[j >> 6] |= (uint64_t)1 << (j & 63);
+
+				if (entry.cell != WALL_CELL && entry.cell != FREE_CELL) {
+					sSpecialCell special = { i, j, entry.cell };
+					specialCells.push_back(special);
+				}
+			}
+		}
+
+		applyRowMask(grid, i, width, mask.data());
+	}
+
+	CollectStartsAndGoals(specialCells, starts, goals);
+
+	// The first start and goal found, bottom row first
+	if (!starts.empty())
+		start = starts[0];
+	if (!goals.empty())
+		goal = goals[0];
+
+	return true;
+}
+
+void cMapLoader::CollectStartsAndGoals(const std::vector<sSpecialCell>& specialCells,
+	std::vector<Pair>& starts, std::vector<Pair>& goals) {
+
+	starts.clear();
+	goals.clear();
+
+	for (int k = 0; k < specialCells.size(); k++) {
+		if (specialCells[k].cell == START_CELL)
+			starts.push_back(std::make_pair(specialCells[k].row, specialCells[k].col));
+		else if (specialCells[k].cell == GOAL_CELL)
+			goals.push_back(std::make_pair(specialCells[k].row, specialCells[k].col));
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "../A-Star Algorithm/cPathGrid.h"
+#include "cMapPalette.h"
+
+// Loads map images straight into a cPathGrid.
+//
+// Pixel colours are looked up in a cMapPalette, by default (R, G, B):
+//     black           (0, 0, 0)       wall
+//     white           (255, 255, 255) free
+//     green           (34, 177, 76)   start
+//     red             (237, 28, 36)   goal
+// Anything else is treated as a wall.
+//
+// Row 0 of the grid is the bottom row of the image, the same way the
+// rows of a (bottom-up) BMP are stored.
+class cMapLoader {
+public:
+	cMapLoader();
+	~cMapLoader();
+
+	// Memory maps the file and parses the full header: 1, 4, 8, 24 and
+	// 32 bit uncompressed images of any size, padded rows, bottom-up or
+	// top-down. 'start' and 'goal' are the first ones found (see
+	// GetStarts/GetGoals), (-1, -1) when the map has none.
+	bool LoadBMP(const std::string& fileName, cPathGrid& grid, eGridLayout layout,
+		Pair& start, Pair& goal);
+
+	// Colours used by the next load
+	void SetPalette(const cMapPalette& palette) { this->palette = palette; }
+	const cMapPalette& GetPalette() const { return palette; }
+
+	// Every cell of the last load that isn't a plain wall or floor,
+	// row by row
+	const std::vector<sSpecialCell>& GetSpecialCells() const { return specialCells; }
+
+	// Every start and goal cell of the last load, bottom row first
+	const std::vector<Pair>& GetStarts() const { return starts; }
+	const std::vector<Pair>& GetGoals() const { return goals; }
+
+	// Picks the start and goal cells out of a list of special cells
+	static void CollectStartsAndGoals(const std::vector<sSpecialCell>& specialCells,
+		std::vector<Pair>& starts, std::vector<Pair>& goals);
+
+	std::string getLastError(void);
+
+private:
+	cMapPalette palette;
+	std::vector<sSpecialCell> specialCells;
+	std::vector<Pair> starts;
+	std::vector<Pair> goals;
+
+	std::string lastError;
+};
@@ -0,0 +1,151 @@
+#include "cMapPalette.h"
+
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MAP_PALETTE_SSE2
+#include <emmintrin.h>
+#endif
+
+// Never matches a 24 bit colour, used while there is no fast path colour
+static const unsigned int NO_COLOUR = 0xffffffff;
+
+cMapPalette::cMapPalette() {
+
+	Clear();
+
+	AddColour(0, 0, 0, WALL_CELL, false);
+	AddColour(255, 255, 255, FREE_CELL, true);
+	AddColour(34, 177, 76, START_CELL, true);
+	AddColour(237, 28, 36, GOAL_CELL, true);
+}
+
+cMapPalette::~cMapPalette() {
+
+}
+
+void cMapPalette::Clear() {
+
+	entries.clear();
+
+	unknown.colour = NO_COLOUR;
+	unknown.cell = WALL_CELL;
+	unknown.walkable = false;
+
+	wallColour = NO_COLOUR;
+	freeColour = NO_COLOUR;
+}
+
+void cMapPalette::AddColour(unsigned char r, unsigned char g, unsigned char b,
+	unsigned char cell, bool walkable) {
+
+	sPaletteEntry entry;
+	entry.colour = ColourKey(b, g, r);
+	entry.cell = cell;
+	entry.walkable = walkable;
+
+	bool replaced = false;
+	for (int k = 0; k < entries.size(); k++) {
+		if (entries[k].colour == entry.colour) {
+			entries[k] = entry;
+			replaced = true;
+		}
+	}
+	if (!replaced)
+		entries.push_back(entry);
+
+	// The vector loop only knows plain walls and floor
+	if (entry.colour == wallColour)
+		wallColour = NO_COLOUR;
+	if (entry.colour == freeColour)
+		freeColour = NO_COLOUR;
+
+	if (cell == WALL_CELL && !walkable)
+		wallColour = entry.colour;
+	else if (cell == FREE_CELL && walkable)
+		freeColour = entry.colour;
+}
+
+const sPaletteEntry& cMapPalette::Lookup(unsigned int colour) const {
+
+	for (int k = 0; k < entries.size(); k++) {
+		if (entries[k].colour == colour)
+			return entries[k];
+	}
+
+	return unknown;
+}
+
+void cMapPalette::classifyPixel(unsigned int colour, int row, int col,
+	uint64_t* walkable, std::vector<sSpecialCell>& specials) const {
+
+	const sPaletteEntry& entry = Lookup(colour);
+
+	if (entry.walkable)
+		walkable[col >> 6] |= (uint64_t)1 << (col & 63);
+
+	if (entry.cell != WALL_CELL && entry.cell != FREE_CELL) {
+		sSpecialCell special;
+		special.row = row;
+		special.col = col;
+		special.cell = entry.cell;
+		specials.push_back(special);
+	}
+}
+
+void cMapPalette::ClassifyRow(const unsigned char* pixels, int width, int bytesPerPixel, size_t rowBytes,
+	int row, uint64_t* walkable, std::vector<sSpecialCell>& specials) const {
+
+	memset(walkable, 0, MaskWords(width) * sizeof(uint64_t));
+
+	int j = 0;
+
+#ifdef MAP_PALETTE_SSE2
+	const __m128i rgbMask = _mm_set1_epi32(0x00ffffff);
+	const __m128i wallKey = _mm_set1_epi32((int)wallColour);
+	const __m128i freeKey = _mm_set1_epi32((int)freeColour);
+
+	// 4 pixels per step, every step loads 16 bytes
+	for (; j + 4 <= width && (size_t)j * bytesPerPixel + 16 <= rowBytes; j += 4) {
+		const unsigned char* p = pixels + (size_t)j * bytesPerPixel;
+		__m128i v = _mm_loadu_si128((const __m128i*)p);
+		__m128i keys;
+
+		if (bytesPerPixel == 4) {
+			keys = _mm_and_si128(v, rgbMask);
+		}
+		else {
+			// Pixels start at bytes 0, 3, 6 and 9
+			__m128i lo = _mm_unpacklo_epi32(v, _mm_srli_si128(v, 3));
+			__m128i hi = _mm_unpacklo_epi32(_mm_srli_si128(v, 6), _mm_srli_si128(v, 9));
+			keys = _mm_and_si128(_mm_unpacklo_epi64(lo, hi), rgbMask);
+		}
+
+		__m128i isFree = _mm_cmpeq_epi32(keys, freeKey);
+		__m128i isWall = _mm_cmpeq_epi32(keys, wallKey);
+
+		int freeBits = _mm_movemask_ps(_mm_castsi128_ps(isFree));
+		int otherBits = ~_mm_movemask_ps(_mm_castsi128_ps(_mm_or_si128(isFree, isWall))) & 0xf;
+
+		// j is a multiple of 4, the 4 bits never straddle two words
+		walkable[j >> 6] |= (uint64_t)freeBits << (j & 63);
+
+		for (int lane = 0; otherBits != 0; lane++, otherBits >>= 1) {
+			if (otherBits & 1) {
+				const unsigned char* pixel = p + lane * bytesPerPixel;
+				classifyPixel(ColourKey(pixel[0], pixel[1], pixel[2]), row, j + lane, walkable, specials);
+			}
+		}
+	}
+#endif
+
+	for (; j < width; j++) {
+		const unsigned char* pixel = pixels + (size_t)j * bytesPerPixel;
+		unsigned int colour = ColourKey(pixel[0], pixel[1], pixel[2]);
+
+		if (colour == freeColour)
+			walkable[j >> 6] |= (uint64_t)1 << (j & 63);
+		else if (colour != wallColour)
+			classifyPixel(colour, row, j, walkable, specials);
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+// Colour coded map cells.
+//
+// Each palette entry maps one pixel colour to a cell type and says if an
+// agent can walk on it. ClassifyRow() turns a whole row of BGR or BGRA
+// pixels into a walkability bitmask plus a short list of the cells that
+// aren't plain walls or floor (start, goal, ...).
+//
+// The wall and floor colours make up nearly every pixel of a map, so
+// those two are compared 4 pixels at a time with SSE2. Only pixels of
+// any other colour fall back to a lookup in the table, which is why more
+// entries can be added without slowing down the loop.
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Cell types, colour coded types of our own can use ids from
+// FIRST_CUSTOM_CELL on
+enum eMapCell
+{
+	WALL_CELL,
+	FREE_CELL,
+	START_CELL,
+	GOAL_CELL,
+	FIRST_CUSTOM_CELL
+};
+
+struct sPaletteEntry {
+	unsigned int colour;	// 0x00RRGGBB
+	unsigned char cell;		// eMapCell or a custom id
+	bool walkable;
+};
+
+// A pixel that isn't a wall or floor
+struct sSpecialCell {
+	int row;
+	int col;
+	unsigned char cell;
+};
+
+class cMapPalette {
+public:
+	// Black walls, white floor, green (34, 177, 76) start and
+	// red (237, 28, 36) goal
+	cMapPalette();
+	~cMapPalette();
+
+	void Clear();
+
+	// Replaces the entry if the colour is already in the table.
+	// WALL_CELL and FREE_CELL colours become the ones the vector loop
+	// tests for.
+	void AddColour(unsigned char r, unsigned char g, unsigned char b,
+		unsigned char cell, bool walkable);
+
+	// Colours that aren't in the table are walls
+	const sPaletteEntry& Lookup(unsigned int colour) const;
+
+	// Pixels as they are stored in a BMP
+	static unsigned int ColourKey(unsigned char b, unsigned char g, unsigned char r)
+	{
+		return ((unsigned int)r << 16) | ((unsigned int)g << 8) | b;
+	}
+
+	// Bits for 'width' cells, 64 to a word
+	static size_t MaskWords(int width) { return ((size_t)width + 63) / 64; }
+
+	// Classifies one row of 3 (BGR) or 4 (BGRA) byte pixels. Bit j of
+	// 'walkable' is set when cell j is walkable, other cells get a
+	// cleared bit. 'rowBytes' is how much can be read from 'pixels',
+	// the vector loop may read past the last pixel but never past that.
+	// Special cells are appended with the given row.
+	void ClassifyRow(const unsigned char* pixels, int width, int bytesPerPixel, size_t rowBytes,
+		int row, uint64_t* walkable, std::vector<sSpecialCell>& specials) const;
+
+private:
+	// Scalar path, for the leftover pixels and rare colours
+	void classifyPixel(unsigned int colour, int row, int col,
+		uint64_t* walkable, std::vector<sSpecialCell>& specials) const;
+
+	std::vector<sPaletteEntry> entries;
+	sPaletteEntry unknown;
+
+	unsigned int wallColour;
+	unsigned int freeColour;
+};
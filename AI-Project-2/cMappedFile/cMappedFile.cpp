@@ -0,0 +1,137 @@
+#include "cMappedFile.h"
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+#include <cstring>
+
+cMappedFile::cMappedFile()
+	: data(nullptr)
+	, size(0)
+#ifdef _WIN32
+	, fileHandle(INVALID_HANDLE_VALUE)
+	, mappingHandle(nullptr)
+#else
+	, fileDescriptor(-1)
+#endif
+{
+}
+
+cMappedFile::~cMappedFile() {
+
+	Close();
+}
+
+bool cMappedFile::Open(const std::string& fileName) {
+
+	Close();
+
+#ifdef _WIN32
+	fileHandle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+		Close();
+		return false;
+	}
+
+	mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mappingHandle == nullptr) {
+		Close();
+		return false;
+	}
+
+	data = (const unsigned char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (data == nullptr) {
+		Close();
+		return false;
+	}
+
+	size = (size_t)fileSize.QuadPart;
+#else
+	fileDescriptor = open(fileName.c_str(), O_RDONLY);
+	if (fileDescriptor == -1)
+		return false;
+
+	struct stat info;
+	if (fstat(fileDescriptor, &info) != 0 || info.st_size == 0) {
+		Close();
+		return false;
+	}
+
+	void* mapping = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	if (mapping == MAP_FAILED) {
+		Close();
+		return false;
+	}
+
+	data = (const unsigned char*)mapping;
+	size = (size_t)info.st_size;
+#endif
+
+	return true;
+}
+
+void cMappedFile::Close() {
+
+#ifdef _WIN32
+	if (data != nullptr)
+		UnmapViewOfFile(data);
+	if (mappingHandle != nullptr)
+		CloseHandle(mappingHandle);
+	if (fileHandle != INVALID_HANDLE_VALUE)
+		CloseHandle(fileHandle);
+
+	mappingHandle = nullptr;
+	fileHandle = INVALID_HANDLE_VALUE;
+#else
+	if (data != nullptr)
+		munmap((void*)data, size);
+	if (fileDescriptor != -1)
+		close(fileDescriptor);
+
+	fileDescriptor = -1;
+#endif
+
+	data = nullptr;
+	size = 0;
+}
+
+// 8 bytes per step: mix each word in with a multiply and a shift
+uint64_t cMappedFile::Checksum(const unsigned char* bytes, size_t count) {
+
+	const uint64_t PRIME = 0x9e3779b97f4a7c15ull;
+
+	uint64_t hash = 0xcbf29ce484222325ull ^ (count * PRIME);
+	size_t k = 0;
+
+	for (; k + 8 <= count; k += 8) {
+		uint64_t word;
+		memcpy(&word, bytes + k, 8);
+
+		hash = (hash ^ word) * PRIME;
+		hash ^= hash >> 29;
+	}
+
+	if (k < count) {
+		uint64_t word = 0;
+		memcpy(&word, bytes + k, count - k);
+
+		hash = (hash ^ word) * PRIME;
+		hash ^= hash >> 29;
+	}
+
+	hash ^= hash >> 32;
+	return hash;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// Read-only memory mapping of a whole file. The contents are paged in
+// by the OS on first touch, nothing is copied into our own buffers.
+class cMappedFile {
+public:
+	cMappedFile();
+	~cMappedFile();
+
+	bool Open(const std::string& fileName);
+	void Close();
+
+	bool IsOpen() const { return data != nullptr; }
+
+	const unsigned char* Data() const { return data; }
+	size_t Size() const { return size; }
+
+	// 64 bit hash of the contents, to tell if a file has changed since
+	// something was made from it. Not a cryptographic hash.
+	uint64_t Checksum() const { return Checksum(data, size); }
+	static uint64_t Checksum(const unsigned char* bytes, size_t count);
+
+private:
+	// Not copyable, the mapping belongs to one object
+	cMappedFile(const cMappedFile&);
+	cMappedFile& operator=(const cMappedFile&);
+
+	const unsigned char* data;
+	size_t size;
+
+#ifdef _WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#else
+	int fileDescriptor;
+#endif
+};
@@ -0,0 +1,49 @@
+#include "cMeshArena.h"
+
+static const size_t ALIGNMENT = 16;
+
+cMeshArena::cMeshArena()
+	: bytesAllocated(0)
+	, bytesReserved(0)
+{
+}
+
+cMeshArena::~cMeshArena() {
+
+	Reset();
+}
+
+void* cMeshArena::Allocate(size_t bytes) {
+
+	bytes = (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+	if (chunks.empty() || chunks.back().size - chunks.back().used < bytes) {
+		sChunk chunk;
+		chunk.size = (bytes > CHUNK_SIZE) ? bytes : CHUNK_SIZE;
+		// new[] is aligned for any fundamental type, 16 bytes on our targets
+		chunk.data = new unsigned char[chunk.size];
+		chunk.used = 0;
+
+		chunks.push_back(chunk);
+		bytesReserved += chunk.size;
+	}
+
+	sChunk& chunk = chunks.back();
+	void* allocation = chunk.data + chunk.used;
+
+	chunk.used += bytes;
+	bytesAllocated += bytes;
+
+	return allocation;
+}
+
+void cMeshArena::Reset() {
+
+	for (size_t k = 0; k < chunks.size(); k++) {
+		delete[] chunks[k].data;
+	}
+
+	chunks.clear();
+	bytesAllocated = 0;
+	bytesReserved = 0;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Bump allocator for the arrays of meshes being loaded. Memory is taken
+// from the system a chunk at a time and handed out front to back; there
+// is no freeing single allocations, Reset() (or the destructor) gives it
+// all back at once. Loading a mesh is a burst of allocations that all
+// die together after the upload, which is exactly that pattern.
+//
+// Not thread safe, every thread uses its own arena.
+class cMeshArena {
+public:
+	// Bigger allocations get a chunk of their own
+	static const size_t CHUNK_SIZE = 4 * 1024 * 1024;
+
+	cMeshArena();
+	~cMeshArena();
+
+	// 16 byte aligned, not zeroed
+	void* Allocate(size_t bytes);
+
+	// Frees every allocation
+	void Reset();
+
+	// Handed out, and taken from the system
+	size_t BytesAllocated() const { return bytesAllocated; }
+	size_t BytesReserved() const { return bytesReserved; }
+
+private:
+	// Not copyable, the allocations point into it
+	cMeshArena(const cMeshArena&);
+	cMeshArena& operator=(const cMeshArena&);
+
+	struct sChunk {
+		unsigned char* data;
+		size_t size;
+		size_t used;
+	};
+
+	std::vector<sChunk> chunks;
+	size_t bytesAllocated;
+	size_t bytesReserved;
+};
@@ -2,6 +2,7 @@
 
 cMeshInfo::cMeshInfo() {
 
+	this->meshHandle = cVAOManager::INVALID_MESH_HANDLE;
 	this->position = glm::vec3(0.f);
 	this->velocity = glm::vec3(0.f);
 	this->up = glm::vec3(0.f, 1.f, 0.f);
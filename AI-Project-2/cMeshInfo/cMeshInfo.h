@@ -18,6 +18,10 @@ public:
 	std::string meshName;
 	std::string friendlyName;
 
+	// meshName's cVAOManager handle, looked up by DrawMesh the first time
+	// the mesh is drawn
+	unsigned int meshHandle;
+
 	glm::vec3 position;
 	glm::vec3 scale;
 	glm::vec3 velocity;
@@ -0,0 +1,316 @@
+#include "cMeshOptimizer.h"
+
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <cstddef>
+
+static const unsigned int NO_INDEX = 0xffffffff;
+
+// Attributes that make two vertices the same, the padding isn't one
+static const size_t VERTEX_KEY_BYTES = offsetof(vertLayout, ignore1);
+
+// Forsyth's scoring constants
+static const float CACHE_DECAY_POWER = 1.5f;
+static const float LAST_TRIANGLE_SCORE = 0.75f;
+static const float VALENCE_BOOST_SCALE = 2.0f;
+static const float VALENCE_BOOST_POWER = 0.5f;
+
+static uint64_t hashVertex(const vertLayout& vertex)
+{
+	const unsigned char* bytes = (const unsigned char*)&vertex;
+
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (size_t k = 0; k < VERTEX_KEY_BYTES; k++) {
+		hash = (hash ^ bytes[k]) * 0x100000001b3ull;
+	}
+	return hash;
+}
+
+// How much emitting a triangle with this vertex helps: a lot when the
+// vertex is near the front of the cache, and more the fewer triangles it
+// has left (so lone vertices get finished instead of reloaded later)
+static float vertexScore(int cachePosition, unsigned int trianglesLeft)
+{
+	if (trianglesLeft == 0)
+		return -1.f;
+
+	float score = 0.f;
+
+	if (cachePosition >= 0) {
+		// The triangle just emitted, all three score the same
+		if (cachePosition < 3) {
+			score = LAST_TRIANGLE_SCORE;
+		}
+		else {
+			float scale = 1.f / (cMeshOptimizer::FORSYTH_CACHE_SIZE - 3);
+			score = powf(1.f - (cachePosition - 3) * scale, CACHE_DECAY_POWER);
+		}
+	}
+
+	score += VALENCE_BOOST_SCALE * powf((float)trianglesLeft, -VALENCE_BOOST_POWER);
+	return score;
+}
+
+void cMeshOptimizer::Optimize(sModelDrawInfo& model, sMeshOptimizeStats& stats) {
+
+	stats.verticesBefore = stats.verticesAfter = model.numberOfVertices;
+
+	if (model.pVertices == nullptr || model.pIndices == nullptr || model.numberOfIndices % 3 != 0)
+		return;
+
+	for (unsigned int k = 0; k < model.numberOfIndices; k++) {
+		if (model.pIndices[k] >= model.numberOfVertices)
+			return;
+	}
+
+	stats.acmrBefore = ACMR(model.pIndices, model.numberOfIndices, ACMR_CACHE_SIZE);
+
+	unsigned int vertexCount = WeldVertices(model.pVertices, model.numberOfVertices,
+		model.pIndices, model.numberOfIndices);
+
+	// Already well ordered meshes can come out a little worse, the score
+	// models an LRU cache and the ACMR a FIFO one
+	std::vector<unsigned int> originalOrder(model.pIndices, model.pIndices + model.numberOfIndices);
+	float acmrWelded = ACMR(model.pIndices, model.numberOfIndices, ACMR_CACHE_SIZE);
+
+	OptimizeTriangleOrder(model.pIndices, model.numberOfIndices, vertexCount);
+
+	if (ACMR(model.pIndices, model.numberOfIndices, ACMR_CACHE_SIZE) > acmrWelded)
+		memcpy(model.pIndices, originalOrder.data(), sizeof(unsigned int) * model.numberOfIndices);
+
+	vertexCount = OptimizeVertexOrder(model.pVertices, vertexCount,
+		model.pIndices, model.numberOfIndices);
+
+	// The array keeps its size, only the front of it is used now
+	model.numberOfVertices = vertexCount;
+
+	stats.verticesAfter = vertexCount;
+	stats.acmrAfter = ACMR(model.pIndices, model.numberOfIndices, ACMR_CACHE_SIZE);
+}
+
+unsigned int cMeshOptimizer::WeldVertices(vertLayout* vertices, unsigned int vertexCount,
+	unsigned int* indices, unsigned int indexCount) {
+
+	// Open addressing, at most half full
+	size_t tableSize = 1;
+	while (tableSize < (size_t)vertexCount * 2)
+		tableSize <<= 1;
+
+	std::vector<unsigned int> table(tableSize, NO_INDEX);
+	std::vector<unsigned int> remap(vertexCount);
+
+	unsigned int kept = 0;
+
+	for (unsigned int v = 0; v < vertexCount; v++) {
+		size_t slot = (size_t)hashVertex(vertices[v]) & (tableSize - 1);
+
+		for (;;) {
+			unsigned int other = table[slot];
+
+			// First of its kind, moves down to the next free place
+			if (other == NO_INDEX) {
+				if (kept != v)
+					vertices[kept] = vertices[v];
+
+				table[slot] = kept;
+				remap[v] = kept;
+				kept++;
+				break;
+			}
+
+			if (memcmp(&vertices[other], &vertices[v], VERTEX_KEY_BYTES) == 0) {
+				remap[v] = other;
+				break;
+			}
+
+			slot = (slot + 1) & (tableSize - 1);
+		}
+	}
+
+	for (unsigned int k = 0; k < indexCount; k++) {
+		indices[k] = remap[indices[k]];
+	}
+
+	return kept;
+}
+
+void cMeshOptimizer::OptimizeTriangleOrder(unsigned int* indices, unsigned int indexCount,
+	unsigned int vertexCount) {
+
+	unsigned int triangleCount = indexCount / 3;
+	if (triangleCount < 2)
+		return;
+
+	// Triangles of every vertex, the first trianglesLeft[v] of its list
+	// are the ones not emitted yet
+	std::vector<unsigned int> trianglesLeft(vertexCount, 0);
+	for (unsigned int k = 0; k < triangleCount * 3; k++) {
+		trianglesLeft[indices[k]]++;
+	}
+
+	std::vector<unsigned int> firstTriangle(vertexCount + 1, 0);
+	for (unsigned int v = 0; v < vertexCount; v++) {
+		firstTriangle[v + 1] = firstTriangle[v] + trianglesLeft[v];
+	}
+
+	std::vector<unsigned int> vertexTriangles(triangleCount * 3);
+	std::vector<unsigned int> filled(vertexCount, 0);
+	for (unsigned int t = 0; t < triangleCount; t++) {
+		for (int c = 0; c < 3; c++) {
+			unsigned int v = indices[t * 3 + c];
+			vertexTriangles[firstTriangle[v] + filled[v]++] = t;
+		}
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> score(vertexCount);
+	for (unsigned int v = 0; v < vertexCount; v++) {
+		score[v] = vertexScore(-1, trianglesLeft[v]);
+	}
+
+	std::vector<float> triangleScore(triangleCount);
+	std::vector<bool> emitted(triangleCount, false);
+
+	int best = 0;
+	for (unsigned int t = 0; t < triangleCount; t++) {
+		triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+		if (triangleScore[t] > triangleScore[best])
+			best = (int)t;
+	}
+
+	// Most recently used first, with room for the 3 vertices pushed in
+	std::vector<unsigned int> cache;
+	std::vector<unsigned int> nextCache;
+	cache.reserve(FORSYTH_CACHE_SIZE + 3);
+	nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+	std::vector<unsigned int> ordered(triangleCount * 3);
+	unsigned int scanCursor = 0;
+
+	for (unsigned int n = 0; n < triangleCount; n++) {
+
+		// Nothing in the cache has triangles left, start somewhere new
+		if (best < 0) {
+			while (emitted[scanCursor])
+				scanCursor++;
+			best = (int)scanCursor;
+		}
+
+		const unsigned int* triangle = &indices[best * 3];
+		ordered[n * 3 + 0] = triangle[0];
+		ordered[n * 3 + 1] = triangle[1];
+		ordered[n * 3 + 2] = triangle[2];
+		emitted[best] = true;
+
+		// Take the triangle off the lists of its vertices
+		for (int c = 0; c < 3; c++) {
+			unsigned int v = triangle[c];
+			unsigned int* list = &vertexTriangles[firstTriangle[v]];
+			unsigned int last = --trianglesLeft[v];
+
+			for (unsigned int k = 0; k <= last; k++) {
+				if (list[k] == (unsigned int)best) {
+					list[k] = list[last];
+					list[last] = best;
+					break;
+				}
+			}
+		}
+
+		// Its vertices move to the front of the cache
+		nextCache.assign(triangle, triangle + 3);
+		for (size_t k = 0; k < cache.size(); k++) {
+			unsigned int v = cache[k];
+			if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+				nextCache.push_back(v);
+		}
+		cache.swap(nextCache);
+
+		// Rescore everything that moved, including what fell out
+		for (size_t k = 0; k < cache.size(); k++) {
+			unsigned int v = cache[k];
+			int position = (k < FORSYTH_CACHE_SIZE) ? (int)k : -1;
+
+			cachePosition[v] = position;
+
+			float newScore = vertexScore(position, trianglesLeft[v]);
+			float delta = newScore - score[v];
+			score[v] = newScore;
+
+			const unsigned int* list = &vertexTriangles[firstTriangle[v]];
+			for (unsigned int t = 0; t < trianglesLeft[v]; t++) {
+				triangleScore[list[t]] += delta;
+			}
+		}
+
+		if (cache.size() > FORSYTH_CACHE_SIZE)
+			cache.resize(FORSYTH_CACHE_SIZE);
+
+		// Next one is the best triangle touching the cache
+		best = -1;
+		float bestScore = -1.f;
+		for (size_t k = 0; k < cache.size(); k++) {
+			unsigned int v = cache[k];
+			const unsigned int* list = &vertexTriangles[firstTriangle[v]];
+
+			for (unsigned int t = 0; t < trianglesLeft[v]; t++) {
+				if (triangleScore[list[t]] > bestScore) {
+					bestScore = triangleScore[list[t]];
+					best = (int)list[t];
+				}
+			}
+		}
+	}
+
+	memcpy(indices, ordered.data(), sizeof(unsigned int) * triangleCount * 3);
+}
+
+unsigned int cMeshOptimizer::OptimizeVertexOrder(vertLayout* vertices, unsigned int vertexCount,
+	unsigned int* indices, unsigned int indexCount) {
+
+	std::vector<unsigned int> newIndex(vertexCount, NO_INDEX);
+	unsigned int used = 0;
+
+	for (unsigned int k = 0; k < indexCount; k++) {
+		unsigned int& index = newIndex[indices[k]];
+		if (index == NO_INDEX)
+			index = used++;
+
+		indices[k] = index;
+	}
+
+	std::vector<vertLayout> original(vertices, vertices + vertexCount);
+	for (unsigned int v = 0; v < vertexCount; v++) {
+		if (newIndex[v] != NO_INDEX)
+			vertices[newIndex[v]] = original[v];
+	}
+
+	return used;
+}
+
+float cMeshOptimizer::ACMR(const unsigned int* indices, unsigned int indexCount, unsigned int cacheSize) {
+
+	unsigned int triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return 0.f;
+
+	std::vector<unsigned int> fifo(cacheSize, NO_INDEX);
+	unsigned int head = 0;
+	unsigned int misses = 0;
+
+	for (unsigned int k = 0; k < triangleCount * 3; k++) {
+		bool hit = false;
+		for (unsigned int c = 0; c < cacheSize && !hit; c++) {
+			hit = (fifo[c] == indices[k]);
+		}
+
+		if (!hit) {
+			fifo[head] = indices[k];
+			head = (head + 1) % cacheSize;
+			misses++;
+		}
+	}
+
+	return (float)misses / triangleCount;
+}
@@ -0,0 +1,410 @@
+#include "cMeshSimplifier.h"
+#include "cMeshOptimizer.h"
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_set>
+
+static const unsigned int NO_INDEX = 0xffffffff;
+
+// Symmetric 4x4 matrix of the plane distances, in doubles since the
+// terms cancel out a lot near the surface
+struct sQuadric {
+	double a00, a01, a02, a11, a12, a22;
+	double b0, b1, b2;
+	double c;
+	double weight;
+};
+
+struct sCollapse {
+	unsigned int from;
+	unsigned int to;
+	float error;
+};
+
+static void addPlane(sQuadric& q, const vertLayout& p0, const vertLayout& p1, const vertLayout& p2)
+{
+	double ux = p1.x - p0.x, uy = p1.y - p0.y, uz = p1.z - p0.z;
+	double vx = p2.x - p0.x, vy = p2.y - p0.y, vz = p2.z - p0.z;
+
+	double nx = uy * vz - uz * vy;
+	double ny = uz * vx - ux * vz;
+	double nz = ux * vy - uy * vx;
+
+	// Twice the area, big triangles count for more
+	double length = sqrt(nx * nx + ny * ny + nz * nz);
+	if (length == 0.0)
+		return;
+
+	nx /= length;
+	ny /= length;
+	nz /= length;
+
+	double d = -(nx * p0.x + ny * p0.y + nz * p0.z);
+	double w = length * 0.5;
+
+	q.a00 += w * nx * nx;
+	q.a01 += w * nx * ny;
+	q.a02 += w * nx * nz;
+	q.a11 += w * ny * ny;
+	q.a12 += w * ny * nz;
+	q.a22 += w * nz * nz;
+	q.b0 += w * nx * d;
+	q.b1 += w * ny * d;
+	q.b2 += w * nz * d;
+	q.c += w * d * d;
+	q.weight += w;
+}
+
+static void addQuadric(sQuadric& q, const sQuadric& other)
+{
+	q.a00 += other.a00;
+	q.a01 += other.a01;
+	q.a02 += other.a02;
+	q.a11 += other.a11;
+	q.a12 += other.a12;
+	q.a22 += other.a22;
+	q.b0 += other.b0;
+	q.b1 += other.b1;
+	q.b2 += other.b2;
+	q.c += other.c;
+	q.weight += other.weight;
+}
+
+// Average distance of 'p' from the planes of both quadrics
+static float collapseError(const sQuadric& a, const sQuadric& b, const vertLayout& p)
+{
+	double x = p.x, y = p.y, z = p.z;
+
+	double a00 = a.a00 + b.a00, a01 = a.a01 + b.a01, a02 = a.a02 + b.a02;
+	double a11 = a.a11 + b.a11, a12 = a.a12 + b.a12, a22 = a.a22 + b.a22;
+
+	double squared = x * x * a00 + y * y * a11 + z * z * a22
+		+ 2.0 * (x * y * a01 + x * z * a02 + y * z * a12)
+		+ 2.0 * (x * (a.b0 + b.b0) + y * (a.b1 + b.b1) + z * (a.b2 + b.b2))
+		+ a.c + b.c;
+
+	double weight = a.weight + b.weight;
+	if (weight == 0.0 || squared <= 0.0)
+		return 0.f;
+
+	return (float)sqrt(squared / weight);
+}
+
+// Unnormalised triangle normal
+static void triangleNormal(const vertLayout& p0, const vertLayout& p1, const vertLayout& p2, float* n)
+{
+	float ux = p1.x - p0.x, uy = p1.y - p0.y, uz = p1.z - p0.z;
+	float vx = p2.x - p0.x, vy = p2.y - p0.y, vz = p2.z - p0.z;
+
+	n[0] = uy * vz - uz * vy;
+	n[1] = uz * vx - ux * vz;
+	n[2] = ux * vy - uy * vx;
+}
+
+// Moving 'from' onto 'to' mustn't turn any of the triangles that stay
+// around 'from' over (or close to it)
+static bool collapseFlips(unsigned int from, unsigned int to, const vertLayout* vertices,
+	const unsigned int* indices, const unsigned int* triangles, unsigned int triangleCount)
+{
+	for (unsigned int k = 0; k < triangleCount; k++) {
+		const unsigned int* triangle = &indices[triangles[k] * 3];
+
+		// These are the ones that disappear
+		if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+			continue;
+
+		const vertLayout* before[3];
+		const vertLayout* after[3];
+		for (int c = 0; c < 3; c++) {
+			before[c] = &vertices[triangle[c]];
+			after[c] = (triangle[c] == from) ? &vertices[to] : before[c];
+		}
+
+		float n0[3], n1[3];
+		triangleNormal(*before[0], *before[1], *before[2], n0);
+		triangleNormal(*after[0], *after[1], *after[2], n1);
+
+		float dot = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2];
+		float lengths = sqrtf((n0[0] * n0[0] + n0[1] * n0[1] + n0[2] * n0[2])
+			* (n1[0] * n1[0] + n1[1] * n1[1] + n1[2] * n1[2]));
+
+		if (dot <= 0.25f * lengths)
+			return true;
+	}
+
+	return false;
+}
+
+unsigned int cMeshSimplifier::Simplify(unsigned int* destination,
+	const unsigned int* indices, unsigned int indexCount,
+	const vertLayout* vertices, unsigned int vertexCount,
+	unsigned int targetIndexCount, float maxError, float& error) {
+
+	error = 0.f;
+
+	std::vector<unsigned int> current(indices, indices + indexCount - indexCount % 3);
+
+	// First vertex at each position, the others on a seam point to it
+	std::vector<unsigned int> positionOf(vertexCount);
+	std::vector<unsigned int> sharing(vertexCount, 0);
+	{
+		size_t tableSize = 1;
+		while (tableSize < (size_t)vertexCount * 2)
+			tableSize <<= 1;
+
+		std::vector<unsigned int> table(tableSize, NO_INDEX);
+
+		for (unsigned int v = 0; v < vertexCount; v++) {
+			const unsigned char* bytes = (const unsigned char*)&vertices[v].x;
+
+			uint64_t hash = 0xcbf29ce484222325ull;
+			for (int k = 0; k < 12; k++) {
+				hash = (hash ^ bytes[k]) * 0x100000001b3ull;
+			}
+
+			size_t slot = (size_t)hash & (tableSize - 1);
+			while (table[slot] != NO_INDEX && memcmp(&vertices[table[slot]].x, bytes, 12) != 0)
+				slot = (slot + 1) & (tableSize - 1);
+
+			if (table[slot] == NO_INDEX)
+				table[slot] = v;
+
+			positionOf[v] = table[slot];
+			sharing[table[slot]]++;
+		}
+	}
+
+	// An edge with no twin going the other way is on an open border
+	std::unordered_set<uint64_t> halfEdges;
+	halfEdges.reserve(current.size());
+	for (size_t k = 0; k < current.size(); k += 3) {
+		for (int c = 0; c < 3; c++) {
+			uint64_t a = positionOf[current[k + c]];
+			uint64_t b = positionOf[current[k + (c + 1) % 3]];
+			halfEdges.insert((a << 32) | b);
+		}
+	}
+
+	// Only vertices alone at their position can move or be moved onto,
+	// and border vertices can't move
+	std::vector<unsigned char> canMove(vertexCount, 0);
+	std::vector<unsigned char> canTarget(vertexCount, 0);
+	for (unsigned int v = 0; v < vertexCount; v++) {
+		canTarget[v] = canMove[v] = (sharing[positionOf[v]] == 1);
+	}
+	for (size_t k = 0; k < current.size(); k += 3) {
+		for (int c = 0; c < 3; c++) {
+			unsigned int a = current[k + c];
+			unsigned int b = current[k + (c + 1) % 3];
+
+			if (halfEdges.count(((uint64_t)positionOf[b] << 32) | positionOf[a]) == 0)
+				canMove[a] = canMove[b] = 0;
+		}
+	}
+
+	std::vector<sQuadric> quadrics(vertexCount, sQuadric());
+	for (size_t k = 0; k < current.size(); k += 3) {
+		const vertLayout& p0 = vertices[current[k]];
+		const vertLayout& p1 = vertices[current[k + 1]];
+		const vertLayout& p2 = vertices[current[k + 2]];
+
+		addPlane(quadrics[current[k]], p0, p1, p2);
+		addPlane(quadrics[current[k + 1]], p0, p1, p2);
+		addPlane(quadrics[current[k + 2]], p0, p1, p2);
+	}
+
+	std::vector<unsigned int> firstTriangle(vertexCount + 1);
+	std::vector<unsigned int> vertexTriangles;
+	std::vector<unsigned int> remap(vertexCount);
+	std::vector<unsigned char> touched(vertexCount);
+	std::vector<sCollapse> collapses;
+
+	// Each pass does the cheapest collapses that don't overlap, then
+	// drops the triangles that collapsed
+	while (current.size() > targetIndexCount) {
+		unsigned int triangleCount = (unsigned int)current.size() / 3;
+
+		std::fill(firstTriangle.begin(), firstTriangle.end(), 0);
+		for (size_t k = 0; k < current.size(); k++) {
+			firstTriangle[current[k] + 1]++;
+		}
+		for (unsigned int v = 0; v < vertexCount; v++) {
+			firstTriangle[v + 1] += firstTriangle[v];
+		}
+
+		vertexTriangles.resize(current.size());
+		std::vector<unsigned int> filled(firstTriangle.begin(), firstTriangle.end() - 1);
+		for (unsigned int t = 0; t < triangleCount; t++) {
+			for (int c = 0; c < 3; c++) {
+				vertexTriangles[filled[current[t * 3 + c]]++] = t;
+			}
+		}
+
+		collapses.clear();
+		for (unsigned int t = 0; t < triangleCount; t++) {
+			for (int c = 0; c < 3; c++) {
+				unsigned int a = current[t * 3 + c];
+				unsigned int b = current[t * 3 + (c + 1) % 3];
+
+				// The twin of the edge looks at it the other way round
+				if (a > b)
+					continue;
+
+				sCollapse collapse;
+				collapse.from = NO_INDEX;
+
+				if (canMove[a] && canTarget[b]) {
+					collapse.from = a;
+					collapse.to = b;
+					collapse.error = collapseError(quadrics[a], quadrics[b], vertices[b]);
+				}
+				if (canMove[b] && canTarget[a]) {
+					float reverse = collapseError(quadrics[a], quadrics[b], vertices[a]);
+					if (collapse.from == NO_INDEX || reverse < collapse.error) {
+						collapse.from = b;
+						collapse.to = a;
+						collapse.error = reverse;
+					}
+				}
+
+				if (collapse.from != NO_INDEX)
+					collapses.push_back(collapse);
+			}
+		}
+
+		std::sort(collapses.begin(), collapses.end(),
+			[](const sCollapse& a, const sCollapse& b) { return a.error < b.error; });
+
+		unsigned int trianglesToRemove = (unsigned int)(current.size() - targetIndexCount) / 3;
+		unsigned int removed = 0;
+		unsigned int applied = 0;
+
+		for (unsigned int v = 0; v < vertexCount; v++) {
+			remap[v] = v;
+		}
+		std::fill(touched.begin(), touched.end(), 0);
+
+		for (size_t k = 0; k < collapses.size() && removed < trianglesToRemove; k++) {
+			const sCollapse& collapse = collapses[k];
+
+			// Sorted, so nothing after this is allowed either
+			if (collapse.error > maxError)
+				break;
+
+			if (touched[collapse.from] || touched[collapse.to])
+				continue;
+
+			const unsigned int* around = &vertexTriangles[firstTriangle[collapse.from]];
+			unsigned int aroundCount = firstTriangle[collapse.from + 1] - firstTriangle[collapse.from];
+
+			if (collapseFlips(collapse.from, collapse.to, vertices, current.data(), around, aroundCount))
+				continue;
+
+			remap[collapse.from] = collapse.to;
+			addQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+
+			if (collapse.error > error)
+				error = collapse.error;
+
+			// Nothing around it moves again in this pass, so the flip
+			// checks above stay true
+			for (unsigned int n = 0; n < aroundCount; n++) {
+				const unsigned int* triangle = &current[around[n] * 3];
+
+				touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = 1;
+
+				if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+					removed++;
+			}
+
+			applied++;
+		}
+
+		if (applied == 0)
+			break;
+
+		size_t kept = 0;
+		for (size_t k = 0; k < current.size(); k += 3) {
+			unsigned int a = remap[current[k]];
+			unsigned int b = remap[current[k + 1]];
+			unsigned int c = remap[current[k + 2]];
+
+			if (a == b || b == c || a == c)
+				continue;
+
+			current[kept++] = a;
+			current[kept++] = b;
+			current[kept++] = c;
+		}
+		current.resize(kept);
+	}
+
+	if (!current.empty())
+		memcpy(destination, current.data(), sizeof(unsigned int) * current.size());
+
+	return (unsigned int)current.size();
+}
+
+void cMeshSimplifier::BuildLODs(sModelDrawInfo& model) {
+
+	model.numberOfLODs = 0;
+
+	if (model.pVertices == nullptr || model.pIndices == nullptr
+		|| model.numberOfIndices / 3 < MIN_LOD_TRIANGLES)
+		return;
+
+	if (!model.hasExtents)
+		model.CalculateExtents();
+
+	float maxError = model.maxExtent * MAX_RELATIVE_ERROR;
+
+	// Every level, one after the other
+	std::vector<unsigned int> allIndices(model.pIndices, model.pIndices + model.numberOfIndices);
+	std::vector<unsigned int> level(model.numberOfIndices);
+
+	unsigned int sourceFirst = 0;
+	unsigned int sourceCount = model.numberOfIndices;
+	float sourceError = 0.f;
+
+	while (model.numberOfLODs < sModelDrawInfo::MAX_LODS) {
+		unsigned int target = (unsigned int)(sourceCount * LOD_REDUCTION) / 3 * 3;
+
+		float error;
+		unsigned int count = Simplify(level.data(), allIndices.data() + sourceFirst, sourceCount,
+			model.pVertices, model.numberOfVertices, target, maxError, error);
+
+		// Not worth a level if it hardly got any smaller
+		if (count == 0 || (uint64_t)count * 5 > (uint64_t)sourceCount * 4)
+			break;
+
+		cMeshOptimizer::OptimizeTriangleOrder(level.data(), count, model.numberOfVertices);
+
+		sModelLOD& lod = model.lods[model.numberOfLODs++];
+		lod.firstIndex = (unsigned int)allIndices.size();
+		lod.numberOfIndices = count;
+		// Each level is made from the one before, so the errors add up
+		lod.error = sourceError + error;
+
+		allIndices.insert(allIndices.end(), level.begin(), level.begin() + count);
+
+		sourceFirst = lod.firstIndex;
+		sourceCount = count;
+		sourceError = lod.error;
+	}
+
+	if (model.numberOfLODs == 0)
+		return;
+
+	// From the same place as the old ones, which only need freeing on the heap
+	unsigned int* oldIndices = model.pIndices;
+	bool onHeap = (model.storage == sModelDrawInfo::HEAP_STORAGE);
+
+	model.pIndices = model.NewIndices((unsigned int)allIndices.size());
+	memcpy(model.pIndices, allIndices.data(), sizeof(unsigned int) * allIndices.size());
+
+	if (onHeap)
+		delete[] oldIndices;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+// Levels of detail built by quadric error simplification (Garland and
+// Heckbert, "Surface Simplification Using Quadric Error Metrics").
+//
+// Every vertex keeps a quadric: the sum of the squared distances to the
+// planes of the triangles around it. Collapsing an edge moves one end
+// onto the other, and the quadric of the pair tells how far that moves
+// the surface. The cheapest collapses go first, a few hundred at a time,
+// until the level has the triangles it was asked for.
+//
+// Collapses only ever move a vertex onto one of its neighbours, so every
+// level reuses the model's own vertices: a level is just another list of
+// indices into the same vertex buffer. Vertices on an open border or on
+// a seam (several vertices at one position, for UVs or hard normals) are
+// never moved, which keeps holes and texture seams where they are.
+
+#include "../cVAOManager/cVAOManager.h"
+
+class cMeshSimplifier {
+public:
+	// Models with fewer triangles don't get any levels
+	static const unsigned int MIN_LOD_TRIANGLES = 1024;
+
+	// Each level aims for this share of the triangles of the one before
+	static constexpr float LOD_REDUCTION = 0.5f;
+
+	// No collapse moves the surface further than this share of the
+	// model's size
+	static constexpr float MAX_RELATIVE_ERROR = 0.05f;
+
+	// Writes a simplified copy of the triangles in 'indices' to
+	// 'destination' (room for indexCount indices), aiming for
+	// 'targetIndexCount'. Stops early when the next collapse would move
+	// the surface more than 'maxError'. Returns the number of indices
+	// written; 'error' gets the largest distance moved, in model units.
+	static unsigned int Simplify(unsigned int* destination,
+		const unsigned int* indices, unsigned int indexCount,
+		const vertLayout* vertices, unsigned int vertexCount,
+		unsigned int targetIndexCount, float maxError, float& error);
+
+	// Fills model.lods, growing pIndices (heap or arena, not mapped) to
+	// hold every level after the model's own triangles.
+	static void BuildLODs(sModelDrawInfo& model);
+};
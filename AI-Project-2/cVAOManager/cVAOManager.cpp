@@ -1,12 +1,17 @@
 #include "cVAOManager.h"
 #include "../OpenGL.h"
+#include "../cMeshArena/cMeshArena.h"
 
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
+#include <glm/gtc/packing.hpp>
 
 #include <vector>
 
 #include <sstream>
+#include <iostream>
+#include <cmath>
+#include <cstring>
 
 sModelDrawInfo::sModelDrawInfo()
 {
@@ -25,6 +30,14 @@ sModelDrawInfo::sModelDrawInfo()
 	this->pVertices = 0;	// or NULL
 	this->pIndices = 0;		// or NULL
 
+	this->hasExtents = false;
+	this->numberOfLODs = 0;
+	this->isQuantized = false;
+
+	this->storage = NO_STORAGE;
+	this->pArena = nullptr;
+	this->keepCPUCopy = false;
+
 	// You could store the max and min values of the 
 	//  vertices here (determined when you load them):
 	glm::vec3 maxValues;
@@ -70,71 +83,211 @@ void sModelDrawInfo::CalculateExtents(void)
 	if (this->extentY > this->maxExtent) { this->maxExtent = this->extentY; }
 	if (this->extentZ > this->maxExtent) { this->maxExtent = this->extentZ; }
 
+	this->hasExtents = true;
+
 	return;
 }
 
-bool cVAOManager::LoadModelIntoVAO(
-		std::string fileName, 
-		sModelDrawInfo &drawInfo,
-	    unsigned int shaderProgramID)
+unsigned int sModelDrawInfo::TotalIndices(void) const
+{
+	if (this->numberOfLODs == 0)
+	{
+		return this->numberOfIndices;
+	}
 
+	const sModelLOD& last = this->lods[this->numberOfLODs - 1];
+	return last.firstIndex + last.numberOfIndices;
+}
+
+vertLayout* sModelDrawInfo::NewVertices(unsigned int count)
 {
-	// Load the model from file
-	// (We do this here, since if we can't load it, there's 
-	//	no point in doing anything else, right?)
+	vertLayout* vertices;
 
-	drawInfo.meshName = fileName;
+	if (this->pArena)
+	{
+		vertices = (vertLayout*)this->pArena->Allocate(sizeof(vertLayout) * count);
+		memset(vertices, 0, sizeof(vertLayout) * count);
+		this->storage = ARENA_STORAGE;
+	}
+	else
+	{
+		vertices = new vertLayout[count]();
+		this->storage = HEAP_STORAGE;
+	}
 
-	// Calculate the min and max values
-	drawInfo.CalculateExtents();
+	return vertices;
+}
 
-	// 
-	// Model is loaded and the vertices and indices are in the drawInfo struct
-	// 
+unsigned int* sModelDrawInfo::NewIndices(unsigned int count)
+{
+	if (this->pArena)
+	{
+		this->storage = ARENA_STORAGE;
+		return (unsigned int*)this->pArena->Allocate(sizeof(unsigned int) * count);
+	}
 
-	// Create a VAO (Vertex Array Object), which will 
-	//	keep track of all the 'state' needed to draw 
-	//	from this buffer...
+	this->storage = HEAP_STORAGE;
+	return new unsigned int[count];
+}
 
-	// Ask OpenGL for a new buffer ID...
-	glGenVertexArrays( 1, &(drawInfo.VAO_ID) );
-	// "Bind" this buffer:
-	// - aka "make this the 'current' VAO buffer
-	glBindVertexArray(drawInfo.VAO_ID);
+void sModelDrawInfo::ReleaseArrays(void)
+{
+	if (this->storage == HEAP_STORAGE)
+	{
+		delete[] this->pVertices;
+		delete[] this->pIndices;
+	}
 
-	// Now ANY state that is related to vertex or index buffer
-	//	and vertex attribute layout, is stored in the 'state' 
-	//	of the VAO... 
+	this->pVertices = 0;
+	this->pIndices = 0;
+	this->storage = NO_STORAGE;
+	this->pArena = nullptr;
 
+	return;
+}
 
-	// NOTE: OpenGL error checks have been omitted for brevity
-//	glGenBuffers(1, &vertex_buffer);
-	glGenBuffers(1, &(drawInfo.VertexBufferID) );
+void sModelDrawInfo::CopyArraysToHeap(void)
+{
+	if (this->storage == HEAP_STORAGE || this->storage == NO_STORAGE)
+	{
+		return;
+	}
 
-//	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-	glBindBuffer(GL_ARRAY_BUFFER, drawInfo.VertexBufferID);
-	// sVert vertices[3]
-	glBufferData( GL_ARRAY_BUFFER, 
-				  sizeof(vertLayout) * drawInfo.numberOfVertices,	// ::g_NumberOfVertsToDraw,	// sizeof(vertices), 
-				  (GLvoid*) drawInfo.pVertices,							// pVertices,			//vertices, 
-				  GL_STATIC_DRAW );
-	// glBindBuffer(GL_ARRAY_BUFFER, 0);
+	vertLayout* vertices = new vertLayout[this->numberOfVertices];
+	memcpy(vertices, this->pVertices, sizeof(vertLayout) * this->numberOfVertices);
 
+	unsigned int* indices = new unsigned int[this->TotalIndices()];
+	memcpy(indices, this->pIndices, sizeof(unsigned int) * this->TotalIndices());
 
-	// Copy the index buffer into the video card, too
-	// Create an index buffer.
-	glGenBuffers( 1, &(drawInfo.IndexBufferID) );
+	this->pVertices = vertices;
+	this->pIndices = indices;
+	this->storage = HEAP_STORAGE;
+	this->pArena = nullptr;
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, drawInfo.IndexBufferID);
+	return;
+}
+
+size_t sModelDrawInfo::ResidentCPUBytes(void) const
+{
+	if (this->storage != HEAP_STORAGE && this->storage != ARENA_STORAGE)
+	{
+		return 0;
+	}
+
+	return sizeof(vertLayout) * this->numberOfVertices + sizeof(unsigned int) * this->TotalIndices();
+}
+
+cVAOManager::cVAOManager()
+{
+	this->m_quantizeVertices = false;
+	this->m_useSharedBuffers = false;
+
+	for (int index = 0; index != 2; index++)
+	{
+		sSharedBuffer& shared = this->m_sharedBuffers[index];
+		shared.VAO_ID = 0;
+		shared.VertexBufferID = 0;
+		shared.IndexBufferID = 0;
+		shared.vertexCapacity = shared.numberOfVertices = 0;
+		shared.indexCapacity = shared.numberOfIndices = 0;
+	}
+}
 
-	glBufferData( GL_ELEMENT_ARRAY_BUFFER,			// Type: Index element array
-	              sizeof( unsigned int ) * drawInfo.numberOfIndices, 
-	              (GLvoid*) drawInfo.pIndices,
-                  GL_STATIC_DRAW );
-	// glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+cVAOManager::~cVAOManager()
+{
+	for (size_t handle = 0; handle != this->m_drawInfos.size(); handle++)
+	{
+		this->m_drawInfos[handle].ReleaseArrays();
+	}
+}
+
+void cVAOManager::SetQuantizeVertices(bool quantize)
+{
+	this->m_quantizeVertices = quantize;
+}
+
+void cVAOManager::SetUseSharedBuffers(bool useShared)
+{
+	this->m_useSharedBuffers = useShared;
+}
+
+// Whether packing the model loses anything that shows
+static bool canQuantize(const sModelDrawInfo& drawInfo)
+{
+	for (unsigned int index = 0; index != drawInfo.numberOfVertices; index++)
+	{
+		const vertLayout& vertex = drawInfo.pVertices[index];
+
+		float colour[3] = { vertex.r, vertex.g, vertex.b };
+		for (int c = 0; c < 3; c++)
+		{
+			if (colour[c] < 0.f || colour[c] > 255.f || colour[c] != floorf(colour[c])) { return false; }
+		}
+
+		float length = sqrtf(vertex.nx * vertex.nx + vertex.ny * vertex.ny + vertex.nz * vertex.nz);
+		if (fabsf(length - 1.f) > 0.001f) { return false; }
+
+		if (fabsf(vertex.texture_u) > cVAOManager::MAX_HALF_UV
+			|| fabsf(vertex.texture_v) > cVAOManager::MAX_HALF_UV) { return false; }
+	}
+
+	return true;
+}
+
+// Unit normal folded onto the octahedron |x| + |y| + |z| = 1, with the
+// lower half flipped out to the corners so it fits in a square
+static glm::vec2 octahedralEncode(glm::vec3 normal)
+{
+	normal /= (fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z));
+
+	glm::vec2 encoded(normal.x, normal.y);
+	if (normal.z < 0.f)
+	{
+		encoded.x = (1.f - fabsf(normal.y)) * (normal.x >= 0.f ? 1.f : -1.f);
+		encoded.y = (1.f - fabsf(normal.x)) * (normal.y >= 0.f ? 1.f : -1.f);
+	}
+	return encoded;
+}
+
+static void packVertices(const sModelDrawInfo& drawInfo, std::vector<sPackedVertex>& packed)
+{
+	packed.resize(drawInfo.numberOfVertices);
+
+	// Flat models have an extent of 0 on one axis
+	glm::vec3 minimum(drawInfo.minX, drawInfo.minY, drawInfo.minZ);
+	glm::vec3 extent(drawInfo.extentX, drawInfo.extentY, drawInfo.extentZ);
+	glm::vec3 scale(extent.x > 0.f ? 1.f / extent.x : 0.f,
+					extent.y > 0.f ? 1.f / extent.y : 0.f,
+					extent.z > 0.f ? 1.f / extent.z : 0.f);
 
-	// Set the vertex attributes.
+	for (unsigned int index = 0; index != drawInfo.numberOfVertices; index++)
+	{
+		const vertLayout& vertex = drawInfo.pVertices[index];
+		sPackedVertex& out = packed[index];
+
+		glm::vec3 fraction = (glm::vec3(vertex.x, vertex.y, vertex.z) - minimum) * scale;
+		out.x = glm::packUnorm1x16(fraction.x);
+		out.y = glm::packUnorm1x16(fraction.y);
+		out.z = glm::packUnorm1x16(fraction.z);
+		out.unused = 0;
+
+		out.r = (unsigned char)vertex.r;
+		out.g = (unsigned char)vertex.g;
+		out.b = (unsigned char)vertex.b;
+		out.a = 255;
+
+		glm::vec2 normal = octahedralEncode(glm::vec3(vertex.nx, vertex.ny, vertex.nz));
+		out.nx = (short)glm::packSnorm1x16(normal.x);
+		out.ny = (short)glm::packSnorm1x16(normal.y);
+
+		out.u = glm::packHalf1x16(vertex.texture_u);
+		out.v = glm::packHalf1x16(vertex.texture_v);
+	}
+}
 
+// Points the bound VAO's attributes at the bound vertex buffer
+static void setVertexAttributes(unsigned int shaderProgramID, bool isQuantized)
+{
 	GLint vPositionLocation = glGetAttribLocation(shaderProgramID, "vPosition");	
 	GLint vColourLocation = glGetAttribLocation(shaderProgramID, "vColour");
 	GLint vNormalLocation = glGetAttribLocation(shaderProgramID, "vNormal");
@@ -142,28 +295,66 @@ bool cVAOManager::LoadModelIntoVAO(
 
 	// Set the vertex attributes for this shader
 	glEnableVertexAttribArray(vPositionLocation);	// vPos
-	glVertexAttribPointer(vPositionLocation, 3,			// vPos
-						    GL_FLOAT, GL_FALSE,
-						    sizeof(vertLayout),
-						    (void*)offsetof(vertLayout, x));
-
 	glEnableVertexAttribArray(vColourLocation);		// vCol
-	glVertexAttribPointer(vColourLocation, 3,			// vCol
-						    GL_FLOAT, GL_FALSE,
-						    sizeof(vertLayout),
-						    (void*)offsetof(vertLayout, r));
-
 	glEnableVertexAttribArray(vNormalLocation);		// vNormal
-	glVertexAttribPointer(vNormalLocation, 3,			// vNormal
-							GL_FLOAT, GL_FALSE,
-							sizeof(vertLayout),
-							(void*)offsetof(vertLayout, nx));
-
 	glEnableVertexAttribArray(vUV2Location);		// vUV2
-	glVertexAttribPointer(vUV2Location, 4,				// vUV2
-						    GL_FLOAT, GL_FALSE,
-							sizeof(vertLayout),						// Stride	(number of bytes)
-							(void*)offsetof(vertLayout, texture_u));
+
+	if (isQuantized)
+	{
+		// Position comes in as 0 to 1 across the bounds and the normal as
+		// the 2 octahedral values, the vertex shader turns them back
+		glVertexAttribPointer(vPositionLocation, 3,			// vPos
+							    GL_UNSIGNED_SHORT, GL_TRUE,
+							    sizeof(sPackedVertex),
+							    (void*)offsetof(sPackedVertex, x));
+
+		glVertexAttribPointer(vColourLocation, 3,			// vCol, not normalized, 0 to 255 like the floats
+							    GL_UNSIGNED_BYTE, GL_FALSE,
+							    sizeof(sPackedVertex),
+							    (void*)offsetof(sPackedVertex, r));
+
+		glVertexAttribPointer(vNormalLocation, 2,			// vNormal
+								GL_SHORT, GL_TRUE,
+								sizeof(sPackedVertex),
+								(void*)offsetof(sPackedVertex, nx));
+
+		glVertexAttribPointer(vUV2Location, 2,				// vUV2
+							    GL_HALF_FLOAT, GL_FALSE,
+								sizeof(sPackedVertex),
+								(void*)offsetof(sPackedVertex, u));
+	}
+	else
+	{
+		glVertexAttribPointer(vPositionLocation, 3,			// vPos
+							    GL_FLOAT, GL_FALSE,
+							    sizeof(vertLayout),
+							    (void*)offsetof(vertLayout, x));
+
+		glVertexAttribPointer(vColourLocation, 3,			// vCol
+							    GL_FLOAT, GL_FALSE,
+							    sizeof(vertLayout),
+							    (void*)offsetof(vertLayout, r));
+
+		glVertexAttribPointer(vNormalLocation, 3,			// vNormal
+								GL_FLOAT, GL_FALSE,
+								sizeof(vertLayout),
+								(void*)offsetof(vertLayout, nx));
+
+		glVertexAttribPointer(vUV2Location, 4,				// vUV2
+							    GL_FLOAT, GL_FALSE,
+								sizeof(vertLayout),						// Stride	(number of bytes)
+								(void*)offsetof(vertLayout, texture_u));
+	}
+}
+
+// Unbinds the VAO, with the attributes left enabled on it but disabled
+// outside it
+static void unbindVertexAttributes(unsigned int shaderProgramID)
+{
+	GLint vPositionLocation = glGetAttribLocation(shaderProgramID, "vPosition");	
+	GLint vColourLocation = glGetAttribLocation(shaderProgramID, "vColour");
+	GLint vNormalLocation = glGetAttribLocation(shaderProgramID, "vNormal");
+	GLint vUV2Location = glGetAttribLocation(shaderProgramID, "vUV2");
 
 	// Now that all the parts are set up, set the VAO to zero
 	glBindVertexArray(0);
@@ -175,10 +366,227 @@ bool cVAOManager::LoadModelIntoVAO(
 	glDisableVertexAttribArray(vColourLocation);
 	glDisableVertexAttribArray(vNormalLocation);
 	glDisableVertexAttribArray(vUV2Location);
+}
+
+// A new buffer of 'newSize' bytes with the first 'usedSize' of the old
+// one copied over on the GPU. The old one is deleted.
+static unsigned int growBuffer(unsigned int oldBufferID, size_t usedSize, size_t newSize)
+{
+	unsigned int newBufferID = 0;
+	glGenBuffers(1, &newBufferID);
 
+	glBindBuffer(GL_COPY_WRITE_BUFFER, newBufferID);
+	glBufferData(GL_COPY_WRITE_BUFFER, newSize, NULL, GL_STATIC_DRAW);
 
-	// Store the draw information into the map
-	this->m_map_ModelName_to_VAOID[ drawInfo.meshName ] = drawInfo;
+	if (oldBufferID != 0)
+	{
+		if (usedSize > 0)
+		{
+			glBindBuffer(GL_COPY_READ_BUFFER, oldBufferID);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, usedSize);
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		}
+		glDeleteBuffers(1, &oldBufferID);
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	return newBufferID;
+}
+
+void cVAOManager::addToSharedBuffer(sModelDrawInfo& drawInfo, const void* vertices, unsigned int shaderProgramID)
+{
+	sSharedBuffer& shared = this->m_sharedBuffers[drawInfo.isQuantized ? 1 : 0];
+	size_t vertexSize = drawInfo.isQuantized ? sizeof(sPackedVertex) : sizeof(vertLayout);
+
+	unsigned int neededVertices = shared.numberOfVertices + drawInfo.numberOfVertices;
+	unsigned int neededIndices = shared.numberOfIndices + drawInfo.TotalIndices();
+
+	if (neededVertices > shared.vertexCapacity || neededIndices > shared.indexCapacity)
+	{
+		// Room for this model and then some, so most loads don't grow it
+		unsigned int vertexCapacity = (shared.vertexCapacity > 0) ? shared.vertexCapacity : SHARED_BUFFER_VERTICES;
+		unsigned int indexCapacity = (shared.indexCapacity > 0) ? shared.indexCapacity : SHARED_BUFFER_INDICES;
+
+		while (vertexCapacity < neededVertices) { vertexCapacity *= 2; }
+		while (indexCapacity < neededIndices) { indexCapacity *= 2; }
+
+		if (shared.VAO_ID == 0)
+		{
+			glGenVertexArrays(1, &(shared.VAO_ID));
+		}
+
+		if (vertexCapacity != shared.vertexCapacity)
+		{
+			shared.VertexBufferID = growBuffer(shared.VertexBufferID,
+				vertexSize * shared.numberOfVertices, vertexSize * vertexCapacity);
+			shared.vertexCapacity = vertexCapacity;
+		}
+
+		if (indexCapacity != shared.indexCapacity)
+		{
+			shared.IndexBufferID = growBuffer(shared.IndexBufferID,
+				sizeof(unsigned int) * shared.numberOfIndices, sizeof(unsigned int) * indexCapacity);
+			shared.indexCapacity = indexCapacity;
+		}
+
+		// The VAO holds on to the buffers it was set up with
+		glBindVertexArray(shared.VAO_ID);
+		glBindBuffer(GL_ARRAY_BUFFER, shared.VertexBufferID);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, shared.IndexBufferID);
+		setVertexAttributes(shaderProgramID, drawInfo.isQuantized);
+		unbindVertexAttributes(shaderProgramID);
+
+		// Models already in it draw from the new buffers too
+		for (size_t handle = 0; handle != this->m_drawInfos.size(); handle++)
+		{
+			sModelDrawInfo& other = this->m_drawInfos[handle];
+			if (other.VAO_ID == shared.VAO_ID)
+			{
+				other.VertexBufferID = shared.VertexBufferID;
+				other.IndexBufferID = shared.IndexBufferID;
+			}
+		}
+	}
+
+	// Indices stay relative to the model's first vertex, the draw adds
+	// VertexBuffer_Start_Index back on (glDrawElementsBaseVertex)
+	glBindBuffer(GL_ARRAY_BUFFER, shared.VertexBufferID);
+	glBufferSubData(GL_ARRAY_BUFFER,
+					vertexSize * shared.numberOfVertices,
+					vertexSize * drawInfo.numberOfVertices,
+					vertices);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, shared.IndexBufferID);
+	glBufferSubData(GL_COPY_WRITE_BUFFER,
+					sizeof(unsigned int) * shared.numberOfIndices,
+					sizeof(unsigned int) * drawInfo.TotalIndices(),
+					drawInfo.pIndices);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	drawInfo.VAO_ID = shared.VAO_ID;
+	drawInfo.VertexBufferID = shared.VertexBufferID;
+	drawInfo.IndexBufferID = shared.IndexBufferID;
+	drawInfo.VertexBuffer_Start_Index = shared.numberOfVertices;
+	drawInfo.IndexBuffer_Start_Index = shared.numberOfIndices;
+
+	shared.numberOfVertices = neededVertices;
+	shared.numberOfIndices = neededIndices;
+}
+
+bool cVAOManager::LoadModelIntoVAO(
+		std::string fileName, 
+		sModelDrawInfo &drawInfo,
+	    unsigned int shaderProgramID)
+
+{
+	// Load the model from file
+	// (We do this here, since if we can't load it, there's 
+	//	no point in doing anything else, right?)
+
+	drawInfo.meshName = fileName;
+
+	// Calculate the min and max values (cooked meshes come with them)
+	if (!drawInfo.hasExtents) {
+		drawInfo.CalculateExtents();
+	}
+
+	// 
+	// Model is loaded and the vertices and indices are in the drawInfo struct
+	// 
+
+	drawInfo.isQuantized = this->m_quantizeVertices && canQuantize(drawInfo);
+
+	// What goes into the vertex buffer
+	std::vector<sPackedVertex> packed;
+	const void* vertexData = drawInfo.pVertices;
+	size_t vertexSize = sizeof(vertLayout);
+
+	if (drawInfo.isQuantized)
+	{
+		packVertices(drawInfo, packed);
+		vertexData = packed.data();
+		vertexSize = sizeof(sPackedVertex);
+	}
+
+	if (this->m_useSharedBuffers)
+	{
+		this->addToSharedBuffer(drawInfo, vertexData, shaderProgramID);
+	}
+	else
+	{
+		// Create a VAO (Vertex Array Object), which will 
+		//	keep track of all the 'state' needed to draw 
+		//	from this buffer...
+
+		// Ask OpenGL for a new buffer ID...
+		glGenVertexArrays( 1, &(drawInfo.VAO_ID) );
+		// "Bind" this buffer:
+		// - aka "make this the 'current' VAO buffer
+		glBindVertexArray(drawInfo.VAO_ID);
+
+		// Now ANY state that is related to vertex or index buffer
+		//	and vertex attribute layout, is stored in the 'state' 
+		//	of the VAO... 
+
+
+		// NOTE: OpenGL error checks have been omitted for brevity
+		glGenBuffers(1, &(drawInfo.VertexBufferID) );
+
+		glBindBuffer(GL_ARRAY_BUFFER, drawInfo.VertexBufferID);
+
+		glBufferData( GL_ARRAY_BUFFER, 
+					  vertexSize * drawInfo.numberOfVertices,
+					  (GLvoid*) vertexData,
+					  GL_STATIC_DRAW );
+
+
+		// Copy the index buffer into the video card, too
+		// Create an index buffer.
+		glGenBuffers( 1, &(drawInfo.IndexBufferID) );
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, drawInfo.IndexBufferID);
+
+		glBufferData( GL_ELEMENT_ARRAY_BUFFER,			// Type: Index element array
+					  sizeof( unsigned int ) * drawInfo.TotalIndices(),	// every LOD
+					  (GLvoid*) drawInfo.pIndices,
+					  GL_STATIC_DRAW );
+
+		setVertexAttributes(shaderProgramID, drawInfo.isQuantized);
+		unbindVertexAttributes(shaderProgramID);
+
+		drawInfo.VertexBuffer_Start_Index = 0;
+		drawInfo.IndexBuffer_Start_Index = 0;
+	}
+
+
+	// The GPU has its copy now, the CPU one only stays if it's needed.
+	// Kept ones move to the heap, the arena or mapping they're in won't
+	// be around for long.
+	if (drawInfo.keepCPUCopy)
+	{
+		drawInfo.CopyArraysToHeap();
+	}
+	else
+	{
+		drawInfo.ReleaseArrays();
+	}
+
+	// A model loaded again under the same name replaces the old one, and
+	// keeps its handle
+	std::map< std::string, unsigned int >::iterator itOld = this->m_map_ModelName_to_Handle.find(drawInfo.meshName);
+	if (itOld != this->m_map_ModelName_to_Handle.end())
+	{
+		this->m_drawInfos[itOld->second].ReleaseArrays();
+		this->m_drawInfos[itOld->second] = drawInfo;
+	}
+	else
+	{
+		// Store the draw information, the map only keeps where it is
+		this->m_map_ModelName_to_Handle[ drawInfo.meshName ] = (unsigned int)this->m_drawInfos.size();
+		this->m_drawInfos.push_back(drawInfo);
+	}
 
 
 	return true;
@@ -190,12 +598,10 @@ bool cVAOManager::FindDrawInfoByModelName(
 		std::string filename,
 		sModelDrawInfo &drawInfo) 
 {
-	std::map< std::string /*model name*/,
-			sModelDrawInfo /* info needed to draw*/ >::iterator 
-		itDrawInfo = this->m_map_ModelName_to_VAOID.find( filename );
+	unsigned int handle = this->GetMeshHandle(filename);
 
 	// Find it? 
-	if ( itDrawInfo == this->m_map_ModelName_to_VAOID.end() )
+	if ( handle == INVALID_MESH_HANDLE )
 	{
 		// Nope
 		return false;
@@ -203,7 +609,66 @@ bool cVAOManager::FindDrawInfoByModelName(
 
 	// Else we found the thing to draw
 	// ...so 'return' that information
-	drawInfo = itDrawInfo->second;
+	drawInfo = this->m_drawInfos[handle];
 	return true;
 }
 
+unsigned int cVAOManager::CreateModelVAO(unsigned int handle, unsigned int shaderProgramID)
+{
+	const sModelDrawInfo& drawInfo = this->m_drawInfos[handle];
+
+	unsigned int VAO_ID = 0;
+	glGenVertexArrays(1, &VAO_ID);
+	glBindVertexArray(VAO_ID);
+
+	glBindBuffer(GL_ARRAY_BUFFER, drawInfo.VertexBufferID);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, drawInfo.IndexBufferID);
+	setVertexAttributes(shaderProgramID, drawInfo.isQuantized);
+
+	return VAO_ID;
+}
+
+unsigned int cVAOManager::GetMeshHandle(const std::string& meshName) const
+{
+	std::map< std::string, unsigned int >::const_iterator itHandle = this->m_map_ModelName_to_Handle.find(meshName);
+
+	if (itHandle == this->m_map_ModelName_to_Handle.end())
+	{
+		return INVALID_MESH_HANDLE;
+	}
+
+	return itHandle->second;
+}
+
+void cVAOManager::PrintMemoryReport(void)
+{
+	size_t totalCPU = 0;
+	size_t totalGPU = 0;
+
+	std::cout << "Mesh memory (CPU bytes, GPU bytes):" << std::endl;
+
+	for (size_t handle = 0; handle != this->m_drawInfos.size(); handle++)
+	{
+		const sModelDrawInfo& drawInfo = this->m_drawInfos[handle];
+
+		size_t vertexSize = drawInfo.isQuantized ? sizeof(sPackedVertex) : sizeof(vertLayout);
+		size_t cpuBytes = drawInfo.ResidentCPUBytes();
+		size_t gpuBytes = vertexSize * drawInfo.numberOfVertices + sizeof(unsigned int) * drawInfo.TotalIndices();
+
+		std::cout << "    " << drawInfo.meshName << ": " << cpuBytes << ", " << gpuBytes << std::endl;
+
+		totalCPU += cpuBytes;
+		totalGPU += gpuBytes;
+	}
+
+	std::cout << "    total: " << totalCPU << ", " << totalGPU << std::endl;
+
+	if (this->m_useSharedBuffers)
+	{
+		size_t reserved = sizeof(vertLayout) * this->m_sharedBuffers[0].vertexCapacity
+						+ sizeof(sPackedVertex) * this->m_sharedBuffers[1].vertexCapacity
+						+ sizeof(unsigned int) * (this->m_sharedBuffers[0].indexCapacity + this->m_sharedBuffers[1].indexCapacity);
+
+		std::cout << "    shared buffers reserved: " << reserved << std::endl;
+	}
+}
@@ -6,6 +6,10 @@
 
 #include <string>
 #include <map>
+#include <vector>
+#include <cstddef>
+
+class cMeshArena;
 
 // The vertex structure 
 //	that's ON THE GPU (eventually) 
@@ -21,6 +25,27 @@ struct vertLayout
 	float ignore2;
 };
 
+// Compressed copy of vertLayout for the GPU, 20 bytes instead of 52
+// (see cVAOManager::SetQuantizeVertices). The vertex shader decodes it.
+struct sPackedVertex
+{
+	unsigned short x, y, z;		// 16 bit fractions of the model's bounds
+	unsigned short unused;
+	unsigned char r, g, b, a;	// the colour as it is in the PLY file, 0 to 255
+	short nx, ny;				// octahedral normal
+	unsigned short u, v;		// half floats
+};
+
+
+// A simplified version of a model (see cMeshSimplifier). It draws the
+// model's own vertices with a range of indices of its own.
+struct sModelLOD
+{
+	unsigned int firstIndex;
+	unsigned int numberOfIndices;
+	// How far the surface moved from the full model, in model units
+	float error;
+};
 
 struct sModelDrawInfo
 {
@@ -30,6 +55,9 @@ struct sModelDrawInfo
 
 	unsigned int VAO_ID;
 
+	// The start indices are 0 unless the model is in the shared buffers
+	// (cVAOManager::SetUseSharedBuffers); then they're its base vertex and
+	// first index in them
 	unsigned int VertexBufferID;
 	unsigned int VertexBuffer_Start_Index;
 	unsigned int numberOfVertices;
@@ -56,14 +84,88 @@ struct sModelDrawInfo
 	//	scale = 5.0/maxExtent --> 5 x 5 x 5
 	float maxExtent;
 
+	// Set by CalculateExtents, or when the extents were loaded along
+	// with the model (cooked meshes)
+	bool hasExtents;
+
+	// Levels of detail, coarser with each one. The full model is LOD 0
+	// and isn't listed; numberOfIndices stays its own count, the indices
+	// of the levels follow in pIndices and the index buffer.
+	static const unsigned int MAX_LODS = 3;
+	unsigned int numberOfLODs;
+	sModelLOD lods[MAX_LODS];
+
+	// The vertex buffer holds sPackedVertex, not vertLayout
+	bool isQuantized;
+
+	// Where pVertices and pIndices live, so they're let go of the right way
+	enum eStorage
+	{
+		NO_STORAGE,
+		HEAP_STORAGE,		// new[]
+		ARENA_STORAGE,		// pArena, freed with the arena
+		MAPPED_STORAGE		// a cooked mesh file, see cMeshCache
+	};
+	eStorage storage;
+
+	// New arrays come from here instead of the heap while it's set
+	// (loader scratch that's gone after the upload)
+	cMeshArena* pArena;
+
+	// Keep the arrays once the model is on the GPU (collision, bounding
+	// boxes). Otherwise cVAOManager lets go of them after the upload.
+	bool keepCPUCopy;
+
+	// From pArena if there is one, with new[] otherwise. Vertices are
+	// zeroed. Doesn't free the arrays they replace.
+	vertLayout* NewVertices(unsigned int count);
+	unsigned int* NewIndices(unsigned int count);
+
+	// Frees heap arrays, forgets arena and mapped ones
+	void ReleaseArrays(void);
+
+	// Arena or mapped arrays copied onto the heap, to outlive their owner
+	void CopyArraysToHeap(void);
+
+	// Heap or arena memory the arrays take up (mapped files are the OS's)
+	size_t ResidentCPUBytes(void) const;
+
 	void CalculateExtents(void);
+
+	// Indices of the model and all its levels
+	unsigned int TotalIndices(void) const;
 };
 
 
 class cVAOManager
 {
 public:
-
+	cVAOManager();
+	// Frees the CPU copies it kept
+	~cVAOManager();
+
+	// Upload models as sPackedVertex from now on (off by default). A
+	// model whose colours aren't whole numbers from 0 to 255, whose
+	// normals aren't unit length or whose UVs go past MAX_HALF_UV is
+	// still uploaded as floats.
+	void SetQuantizeVertices(bool quantize);
+
+	// Half floats are 1/512 apart here, tiled UVs beyond it would blur
+	static constexpr float MAX_HALF_UV = 4.f;
+
+	// Upload models into one big vertex buffer and index buffer behind a
+	// single VAO from now on (off by default), so drawing one after the
+	// other doesn't switch VAOs. Draw them with glDrawElementsBaseVertex.
+	// Packed and float models have a VAO each, their layouts differ.
+	void SetUseSharedBuffers(bool useShared);
+
+	// What the shared buffers start with, they double when they fill up
+	static const unsigned int SHARED_BUFFER_VERTICES = 64 * 1024;
+	static const unsigned int SHARED_BUFFER_INDICES = 256 * 1024;
+
+	// The arrays are let go of once they're uploaded, unless the model
+	// has keepCPUCopy; the manager owns the ones it keeps, and drawInfo
+	// is left the same as the copy stored
 	bool LoadModelIntoVAO(std::string fileName, 
 						  sModelDrawInfo &drawInfo, 
 						  unsigned int shaderProgramID);
@@ -72,13 +174,59 @@ public:
 	bool FindDrawInfoByModelName(std::string filename,
 								 sModelDrawInfo &drawInfo);
 
+	// Models are also numbered in the order they're first loaded. Look the
+	// handle up once (cMeshInfo::meshHandle) and per-draw lookups are an
+	// array index instead of a string search and a copy.
+	static const unsigned int INVALID_MESH_HANDLE = 0xffffffff;
+
+	// INVALID_MESH_HANDLE if no model has that name
+	unsigned int GetMeshHandle(const std::string& meshName) const;
+
+	// The handle must be valid. Loading more models can move the array,
+	// don't hold on to the pointer.
+	const sModelDrawInfo* GetDrawInfo(unsigned int handle) const
+	{
+		return &this->m_drawInfos[handle];
+	}
+
+	// A new VAO over the model's vertex and index buffers, left bound so
+	// the caller can add attributes of its own (see cInstancedMesh). It
+	// points at the buffers as they are now; shared buffers that grow
+	// afterwards get new IDs.
+	unsigned int CreateModelVAO(unsigned int handle, unsigned int shaderProgramID);
+
 	std::string getLastError(bool bAndClear = true);
 
+	// CPU and GPU bytes of every model, to the console
+	void PrintMemoryReport(void);
+
 private:
 
+	// Indexed by handle
+	std::vector< sModelDrawInfo > m_drawInfos;
+
 	std::map< std::string /*model name*/,
-		      sModelDrawInfo /* info needed to draw*/ >
-		m_map_ModelName_to_VAOID;
+		      unsigned int /* handle */ >
+		m_map_ModelName_to_Handle;
+
+	bool m_quantizeVertices;
+
+	struct sSharedBuffer
+	{
+		unsigned int VAO_ID;
+		unsigned int VertexBufferID;
+		unsigned int IndexBufferID;
+		unsigned int vertexCapacity, numberOfVertices;
+		unsigned int indexCapacity, numberOfIndices;
+	};
+
+	// Float models, then packed ones
+	sSharedBuffer m_sharedBuffers[2];
+	bool m_useSharedBuffers;
+
+	// Appends the model, growing the buffers if it doesn't fit
+	void addToSharedBuffer(sModelDrawInfo& drawInfo, const void* vertices,
+						   unsigned int shaderProgramID);
 
 };
 
@@ -4,6 +4,9 @@
 #include "Draw Mesh/DrawMesh.h"
 #include "Draw Bounding Box/DrawBoundingBox.h"
 #include "A-Star Algorithm/A-Star.h"
+#include "A-Star Algorithm/Benchmark.h"
+#include "A-Star Algorithm/cMapEditor.h"
+#include "cMapLoader/cGridFile.h"
 
 #include <glm/glm.hpp>
 #include <glm/vec4.hpp>
@@ -12,6 +15,10 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "PlyFileLoader/PlyFileLoader.h"
+#include "PlyFileLoader/cMeshLoadQueue.h"
+#include "PlyFileLoader/cMeshCache.h"
+#include "cMeshOptimizer/cMeshOptimizer.h"
+#include "cMeshOptimizer/cMeshSimplifier.h"
 #include "cShaderManager/cShaderManager.h"
 #include "cVAOManager/cVAOManager.h"
 #include "cLightManager/cLightManager.h"
@@ -22,6 +29,7 @@
 #include <sstream>
 #include <fstream>
 #include <vector>
+#include <algorithm>
 #include <chrono>
 
 #include <stdlib.h>
@@ -42,7 +50,6 @@ sModelDrawInfo player_obj;
 cMeshInfo* full_screen_quad;
 cMeshInfo* skybox_sphere_mesh;
 cMeshInfo* player_mesh;
-cMeshInfo* cube;
 cMeshInfo* agent;
 
 cMeshInfo* bulb_mesh;
@@ -51,7 +58,6 @@ cLight* pointLight;
 unsigned int readIndex = 0;
 int object_index = 0;
 int elapsed_frames = 0;
-int index = 0;
 
 bool enableMouse = false;
 bool useFBO = false;
@@ -66,9 +72,16 @@ void ManageLights(void);
 float RandomFloat(float a, float b);
 bool RandomizePositions(cMeshInfo* mesh);
 void LoadPlyFilesIntoVAO(void);
+bool ConvertMeshesToBinary(void);
+void ReportMeshOptimization(void);
 int A_STAR_DRIVER();
-bool BitmapStream(std::string filePath, std::vector<std::vector<glm::vec3>>& v);
-void GenerateCubes(glm::vec3& startPos, float tileSize, std::vector<cMeshInfo*>& blocks);
+void GenerateCubes(glm::vec3& startPos, float tileSize, cInstancedMesh* blocks);
+void PlanPath(Pair from, bool verbose);
+void SpawnCrowd(void);
+void RouteCrowd(void);
+bool PathIsClear(const cCompactPath& route, cCompactPath::Iterator step);
+bool PickCell(const glm::mat4& view, const glm::mat4& projection, Pair& cell);
+void EditCell(Pair cell);
 void RenderToFBO(GLFWwindow* window, sCamera* camera, glm::mat4& view, glm::mat4& projection,
     GLuint eyeLocationLocation, GLuint viewLocation, GLuint projectionLocation,
     GLuint modelLocaction, GLuint modelInverseLocation);
@@ -86,12 +99,95 @@ glm::vec3 direction(0.f);
 // attenuation on all lights
 glm::vec4 constLightAtten = glm::vec4(1.0f);
 
-std::vector<std::vector<glm::vec3>> graph;
-std::vector<std::vector<glm::vec3>> positions(64, std::vector<glm::vec3>(64));
-std::vector<cMeshInfo*> cubes;
-std::vector<glm::vec2> path;
+std::vector<std::vector<glm::vec3>> positions;
+// Every wall, start and goal cube, drawn in one instanced call
+cInstancedMesh* cubes;
+
+// Instance of the wall cube of every cell, NO_CUBE where there never was
+// a wall. Cubes of walls that were removed are just hidden.
+const int NO_CUBE = -1;
+std::vector<std::vector<int>> cellCubes;
+const float WALL_TILE_SIZE = 75.f;
+
+// Path found by the A* search, and the cell the agent is on
+cCompactPath path;
+cCompactPath::Iterator pathStep;
+// The agent's cell, also once an edit left it without a path
+Pair pathAgentCell;
+
+// Walkability of every cell, in a cache friendly layout
+// (run with --benchmark to compare the layouts on large maps)
+cPathGrid pathGrid;
+const eGridLayout PATH_GRID_LAYOUT = TILED_LAYOUT;
+
+// Empty rectangles of the map, searches jump across them
+cRectangularSymmetry symmetry;
+const bool USE_SYMMETRY_REDUCTION = true;
+
+// Footprint of the agent in cells (AGENT_SIZE x AGENT_SIZE)
+const int AGENT_SIZE = 1;
+
+// Clicking a cell toggles its wall, the grid, clearance and symmetry
+// rectangles are patched in place
+cMapEditor mapEditor;
+
+// Map image, and the precompiled map made from it
+const std::string MAP_BMP_FILE = "../assets/textures/ex_traversal_graph.bmp";
+const std::string MAP_GRID_FILE = "../assets/textures/ex_traversal_graph.grid";
+
+// Source/Destination cells found in the map. The agent the camera
+// follows goes from the first start to the first goal.
+Pair srcCell;
+Pair destCell;
+
+// Every start and goal of the map
+std::vector<Pair> startCells;
+std::vector<Pair> goalCells;
+
+// One more agent on every other start. They are routed together, by a
+// single batch search, each to the goal nearest to it.
+struct sCrowdAgent {
+    cMeshInfo* mesh;
+    Pair cell;
+    cCompactPath path;
+    cCompactPath::Iterator step;
+};
+std::vector<sCrowdAgent> crowd;
+
+// Real-time agent search
+A_STAR* realTimeSearch;
+const int REAL_TIME_LOOKAHEAD = 32;
+
+enum eAgentMode
+{
+    FOLLOW_FULL_PATH,   // A* runs once up front, agent replays the path
+    REAL_TIME_SEARCH    // LSS-LRTA*, agent plans a bounded lookahead every move
+};
+
+eAgentMode theAgentMode = FOLLOW_FULL_PATH;
 
-int simplifiedGraph[64][64];
+// Search used to build the full path at startup
+enum eSearchMode
+{
+    ASTAR_SEARCH,
+    MEMORY_BOUNDED_SEARCH,  // IDA* + transposition table, capped at SEARCH_MEMORY_LIMIT
+    PARALLEL_SEARCH,        // HDA*, one worker per core
+    BIDIRECTIONAL_SEARCH    // MM, meets in the middle
+};
+
+eSearchMode theSearchMode = ASTAR_SEARCH;
+const size_t SEARCH_MEMORY_LIMIT = 256 * 1024;
+
+// Weld and reorder meshes for the vertex cache when they are first cooked
+const bool OPTIMIZE_MESHES = true;
+// Cook simplified levels of detail for the big meshes, DrawMesh picks
+// one by how big the mesh is on screen
+const bool BUILD_MESH_LODS = true;
+// Upload vertices as 20 byte sPackedVertex instead of 52 byte vertLayout
+const bool QUANTIZE_VERTICES = true;
+// Put every mesh in one shared vertex and index buffer, so the draws
+// don't switch VAOs
+const bool USE_SHARED_MESH_BUFFERS = true;
 
 enum eEditMode
 {
@@ -178,6 +274,26 @@ static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, i
     if (key == GLFW_KEY_F1 && action == GLFW_PRESS) {
         enableMouse = !enableMouse;
     }
+    // Switch between following the full A* path and real-time search,
+    // the agent restarts from the start cell either way
+    if (key == GLFW_KEY_F2 && action == GLFW_PRESS) {
+        if (theAgentMode == FOLLOW_FULL_PATH) {
+            theAgentMode = REAL_TIME_SEARCH;
+        }
+        else {
+            theAgentMode = FOLLOW_FULL_PATH;
+        }
+        realTimeSearch->InitRealTimeSearch(pathGrid, srcCell, destCell);
+
+        // The path may have been replanned from halfway, cut off or
+        // walled over by edits made since
+        if (path.Empty() || path.Start() != srcCell || !PathIsClear(path, path.begin())) {
+            PlanPath(srcCell, false);
+        }
+        pathStep = path.begin();
+        pathAgentCell = srcCell;
+        elapsed_frames = 0;
+    }
 
     switch (theEditMode)
     {
@@ -329,6 +445,14 @@ static void MouseCallBack(GLFWwindow* window, double xposition, double yposition
     }
 }
 
+// A left click toggles the wall of the cell under the cursor (or the
+// centre of the screen while the cursor is captured), picked in Update
+static void MouseButtonCallBack(GLFWwindow* window, int button, int action, int mods) {
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
+        mouseClick = true;
+    }
+}
+
 static void ScrollCallBack(GLFWwindow* window, double xoffset, double yoffset) {
     if (fov >= 1.f && fov <= 45.f) {
         fov -= yoffset;
@@ -384,6 +508,7 @@ void Initialize() {
 
     // mouse and scroll callback
     glfwSetCursorPosCallback(window, MouseCallBack);
+    glfwSetMouseButtonCallback(window, MouseButtonCallBack);
     glfwSetScrollCallback(window, ScrollCallBack);
 
     // capture mouse input
@@ -465,6 +590,8 @@ void Render() {
 
     // VAO Manager
     VAOMan = new cVAOManager();
+    VAOMan->SetQuantizeVertices(QUANTIZE_VERTICES);
+    VAOMan->SetUseSharedBuffers(USE_SHARED_MESH_BUFFERS);
 
     // Scene
     std::cout << "\nLoading assets..." << std::endl;
@@ -545,66 +672,62 @@ void Render() {
     // reads scene descripion files for positioning and other info
     ReadSceneDescription(meshArray);
 
-    // Read the bmp pixel data for info on wall placement
-    if (!BitmapStream("../assets/textures/ex_traversal_graph.bmp", graph)) {
-        std::cout << "Could not open BMP file." << std::endl;
-    }
-
-    // offset
-    wallPos = glm::vec3(-2500.0, 0.0, -2000.0);
-
-    // Generate the cube meshes and put them in a vector
-    GenerateCubes(wallPos, 75.f, cubes);
-
-    // initialize
-    glm::vec2 startPos = glm::vec2(0);
-    glm::vec2 goalPos = glm::vec2(0);
-
-    // Iterate the graph of pixel colors and convert it  
-    // into a format that the A* algorithm understands 
-    // (Array of 0s and 1s)
-    // 
-    // black pixel(0) == blocked
-    // white pixel(1) == unblocked
+    // The map comes from the precompiled .grid file next to the bmp,
+    // with the clearance and symmetry rectangles already worked out.
+    // It's (re)built from the bmp whenever the bmp has changed.
+    //
+    // black pixel == blocked
+    // white pixel == unblocked
     // red pixel == goal node
     // green pixel == start node
-    for (int i = 0; i < graph.size(); i++) {
-        for (int j = 0; j < graph[i].size(); j++) {
-            if (graph[i][j] == glm::vec3(0.f)) {
-                simplifiedGraph[i][j] = 0;
-            }
-            else if (graph[i][j] == glm::vec3(255.f)) {
-                simplifiedGraph[i][j] = 1;
-            }
-            else if (graph[i][j] == glm::vec3(76, 177, 34)) {
-                startPos.x = i;
-                startPos.y = j;
-
-                simplifiedGraph[i][j] = 1;
-            }
-            else if (graph[i][j] == glm::vec3(36, 28, 237)) {
-                goalPos.x = i;
-                goalPos.y = j;
+    cGridFile gridFile;
+    if (!gridFile.Load(MAP_GRID_FILE, MAP_BMP_FILE, pathGrid, PATH_GRID_LAYOUT, srcCell, destCell, &symmetry)) {
+        std::cout << "Rebuilding the map: " << gridFile.getLastError() << std::endl;
 
-                simplifiedGraph[i][j] = 1;
-            }
+        if (!gridFile.Convert(MAP_BMP_FILE, MAP_GRID_FILE, PATH_GRID_LAYOUT)
+            || !gridFile.Load(MAP_GRID_FILE, MAP_BMP_FILE, pathGrid, PATH_GRID_LAYOUT, srcCell, destCell, &symmetry)) {
+            std::cout << "Could not load the map: " << gridFile.getLastError() << std::endl;
         }
     }
 
-    // Source/Start
-    Pair src = make_pair(startPos.x, startPos.y);
+    // Sections a converter may have left out
+    if (!gridFile.HasClearance()) {
+        pathGrid.UpdateClearance();
+    }
+    if (!gridFile.HasSymmetry()) {
+        symmetry.Build(pathGrid);
+    }
 
-    // Destination
-    Pair dest = make_pair(goalPos.x, goalPos.y);
+    startCells = gridFile.GetStarts();
+    goalCells = gridFile.GetGoals();
+    if (startCells.empty() && pathGrid.IsInside(srcCell.first, srcCell.second)) {
+        startCells.push_back(srcCell);
+    }
+    if (goalCells.empty() && pathGrid.IsInside(destCell.first, destCell.second)) {
+        goalCells.push_back(destCell);
+    }
 
-    // Object init
-    A_STAR aStar;
+    // offset
+    wallPos = glm::vec3(-2500.0, 0.0, -2000.0);
+
+    // Generate the cube instances
+    cubes = new cInstancedMesh("wall_cube");
+    GenerateCubes(wallPos, WALL_TILE_SIZE, cubes);
+
+    // Edits of the map keep the search structures up to date
+    mapEditor.Attach(&pathGrid, &symmetry);
 
     // Run the actual search and print results
-    aStar.aStarSearch(simplifiedGraph, src, dest);
+    PlanPath(srcCell, true);
 
-    // Get the path that was found
-    path = aStar.GetPath();
+    // Everyone else heads for their nearest goal
+    SpawnCrowd();
+    RouteCrowd();
+
+    // Real-time search starts from the same cell, but plans as it goes
+    realTimeSearch = new A_STAR();
+    realTimeSearch->SetAgentSize(AGENT_SIZE);
+    realTimeSearch->InitRealTimeSearch(pathGrid, srcCell, destCell);
 
     std::cout << std::endl;
 }
@@ -651,15 +774,27 @@ void Update() {
     if (enableMouse) {
         view = glm::lookAt(camera->position, camera->position + camera->target, upVector);
         projection = glm::perspective(glm::radians(fov), ratio, 0.1f, 10000.f);
+        SetLODProjection(glm::radians(fov), height);
     }
     else {
         view = glm::lookAt(camera->position, camera->target, upVector);
         projection = glm::perspective(0.6f, ratio, 0.1f, 10000.f);
+        SetLODProjection(0.6f, height);
     }
 
     GLint eyeLocationLocation = glGetUniformLocation(shaderID, "eyeLocation");
     glUniform4f(eyeLocationLocation, camera->position.x, camera->position.y, camera->position.z, 1.f);
 
+    // Toggle the wall of the cell that was clicked
+    if (mouseClick) {
+        mouseClick = false;
+
+        Pair pickedCell;
+        if (PickCell(view, projection, pickedCell)) {
+            EditCell(pickedCell);
+        }
+    }
+
     model = glm::mat4(1.f);
 
     glUniformMatrix4fv(viewLocation, 1, GL_FALSE, glm::value_ptr(view));
@@ -673,27 +808,46 @@ void Update() {
     // Increment the frame counter
     elapsed_frames++;
 
+    // The crowd moves on the same ticks as the agent
+    bool crowdStep = elapsed_frames > 10;
+
     // Draw scene meshes
     for (int i = 0; i < meshArray.size(); i++) {
 
         cMeshInfo* currentMesh = meshArray[i];
 
         // Check if the current object is the agent
-        if (currentMesh->friendlyName == "agent") {
+        if (currentMesh->friendlyName == "agent" && theAgentMode == REAL_TIME_SEARCH) {
+
+            // Stays where it is if the map has no start for it
+            Pair agentCell = realTimeSearch->GetRealTimePosition();
+            if (pathGrid.IsInside(agentCell.first, agentCell.second)) {
+                currentMesh->position = positions[agentCell.first][agentCell.second];
+            }
+
+            // Plan a bounded lookahead and take one step after x amount of frames
+            if (elapsed_frames > 10) {
+                realTimeSearch->RealTimeStep(pathGrid, REAL_TIME_LOOKAHEAD, agentCell);
+
+                // Reset the frame counter for a new iteration
+                elapsed_frames = 0;
+            }
+        }
+        else if (currentMesh->friendlyName == "agent" && !path.Empty()) {
 
             // Assign agent position according to the path discovered by the A* algorithm
-            currentMesh->position = positions[(int)path[index].x][(int)path[index].y];
+            Pair agentCell = *pathStep;
+            currentMesh->position = positions[agentCell.first][agentCell.second];
 
             // Move to the next position after x amount of frames
             if (elapsed_frames > 10) {
-                // Did we hit the goal?
-                if (index == path.size() - 1) {
-                    // stay there then
-                    index = path.size() - 1;
-                }
-                else { // No?
-                    // Next position on the list
-                    index++;
+                cCompactPath::Iterator nextStep = pathStep;
+                ++nextStep;
+
+                // Next position on the list, or stay there if we hit the goal
+                if (nextStep != path.end()) {
+                    pathStep = nextStep;
+                    pathAgentCell = *pathStep;
                 }
                 // Reset the frame counter for a new iteration
                 elapsed_frames = 0;
@@ -712,13 +866,31 @@ void Update() {
         
     }
     
-    // Draw the walls the agent will traverse through
-    for (int i = 0; i < cubes.size(); i++) {
+    // Draw the walls the agent will traverse through, all in one call
+    DrawInstancedMesh(cubes,            // the wall, start and goal cubes
+                      shaderID,         // Compiled Shader ID
+                      VAOMan,           // Instance of the VAO Manager
+                      modelLocaction,   // UL for model matrix
+                      modelInverseLocation); // UL for transpose of model matrix
+
+    // Move and draw the crowd
+    for (int i = 0; i < crowd.size(); i++) {
+
+        sCrowdAgent& member = crowd[i];
+
+        if (crowdStep && !member.path.Empty()) {
+            cCompactPath::Iterator nextStep = member.step;
+            ++nextStep;
+
+            // Next position on the list, or stay there if we hit the goal
+            if (nextStep != member.path.end()) {
+                member.step = nextStep;
+                member.cell = *nextStep;
+            }
+        }
+        member.mesh->position = positions[member.cell.first][member.cell.second];
 
-        cMeshInfo* currentMesh = cubes[i];
-         
-        // Draw all the meshes pushed onto the vector
-        DrawMesh(currentMesh,           // theMesh
+        DrawMesh(member.mesh,           // theMesh
                  model,                 // Model Matrix
                  shaderID,              // Compiled Shader ID
                  TextureMan,            // Instance of the Texture Manager
@@ -727,6 +899,9 @@ void Update() {
                  modelLocaction,        // UL for model matrix
                  modelInverseLocation); // UL for transpose of model matrix
     }
+    if (crowdStep) {
+        elapsed_frames = 0;
+    }
 
     // Draw the skybox
     DrawMesh(skybox_sphere_mesh, matIdentity, shaderID, 
@@ -788,6 +963,8 @@ void Update() {
 
 void Shutdown() {
 
+    cMeshCache::ReleaseAll();
+
     glfwDestroyWindow(window);
     glfwTerminate();
 
@@ -818,130 +995,260 @@ void ReadFromFile(std::string filePath) {
     readFile.close();
 }
 
-struct BMPHeader {
-    unsigned char headerField[2];
-    unsigned char sizeOfBMP[4];
-    unsigned char reserved1[2];
-    unsigned char reserved2[2];
-    unsigned char dataOffset[4];
-};
+void GenerateCubes(glm::vec3& startPos, float tileSize, cInstancedMesh* blocks) {
 
-struct Color {
-    unsigned char r;
-    unsigned char g;
-    unsigned char b;
-};
+    glm::vec3 temp = startPos;
+
+    startPos.y += 40.f;
 
-bool BitmapStream(std::string filePath, std::vector<std::vector<glm::vec3>>& v) {
+    positions.assign(pathGrid.Rows(), std::vector<glm::vec3>(pathGrid.Cols()));
+    cellCubes.assign(pathGrid.Rows(), std::vector<int>(pathGrid.Cols(), NO_CUBE));
 
-    std::ifstream bmpStream;
-    bmpStream.open(filePath);
+    for (int i = 0; i < pathGrid.Rows(); i++) {
+        for (int j = 0; j < pathGrid.Cols(); j++) {
+            positions[i][j] = startPos;
 
-    if (!bmpStream.is_open()) {
-        return false;
+            if (!pathGrid.IsWalkable(i, j)) {
+                cellCubes[i][j] = blocks->AddInstance(startPos, tileSize, glm::vec4(0.f, 0.f, 0.f, 1.f));
+            }
+
+            startPos.x += tileSize;
+        }
+        startPos.x = temp.x;
+        startPos.z += tileSize;
     }
 
-    bmpStream.seekg(0);
+    // Markers for every goal and start
+    for (int i = 0; i < goalCells.size(); i++) {
+        blocks->AddInstance(positions[goalCells[i].first][goalCells[i].second], tileSize, glm::vec4(10, 0, 0, 1.f));
+    }
+    for (int i = 0; i < startCells.size(); i++) {
+        blocks->AddInstance(positions[startCells[i].first][startCells[i].second], tileSize, glm::vec4(0, 10, 0, 1.f));
+    }
+    int breakPoint = 0;
+}
 
-    BMPHeader fileHeader;
-    bmpStream.read((char*)&fileHeader.headerField, sizeof(fileHeader));
-    bmpStream.seekg(fileHeader.dataOffset[0]);
+// Runs the selected search from 'from' to the goal, the agent follows
+// the path from its first cell
+void PlanPath(Pair from, bool verbose) {
 
-    printf("\n");
+    A_STAR aStar;
+    aStar.SetVerbose(verbose);
 
-    // Assumes the size of the image is 64x64
-    std::vector<glm::vec3> localgraph(4096);
+    if (USE_SYMMETRY_REDUCTION) {
+        aStar.SetSymmetryReduction(&symmetry);
+    }
+    aStar.SetAgentSize(AGENT_SIZE);
 
-    Color color;
-    for (int i = 0; i < 4096; i++) {
-        bmpStream.read((char*)&color, 3);
+    switch (theSearchMode)
+    {
+        case ASTAR_SEARCH:
+            aStar.aStarSearch(pathGrid, from, destCell);
+            break;
+        case MEMORY_BOUNDED_SEARCH:
+            aStar.memoryBoundedSearch(pathGrid, from, destCell, SEARCH_MEMORY_LIMIT);
+            break;
+        case PARALLEL_SEARCH:
+            aStar.parallelSearch(pathGrid, from, destCell, 0);
+            break;
+        case BIDIRECTIONAL_SEARCH:
+            aStar.bidirectionalSearch(pathGrid, from, destCell);
+            break;
+    }
+
+    // Get the path that was found
+    path = aStar.GetCompactPath();
+    pathStep = path.begin();
+    pathAgentCell = from;
+}
 
-        localgraph[i].r = (int)color.r;
-        localgraph[i].g = (int)color.g;
-        localgraph[i].b = (int)color.b;
+// One crowd agent for every start besides the first
+void SpawnCrowd(void) {
+
+    crowd.clear();
+    crowd.reserve(startCells.size());
+
+    for (int i = 1; i < startCells.size(); i++) {
+        sCrowdAgent member;
+        member.mesh = new cMeshInfo();
+        member.mesh->meshName = "pyramid";
+        member.mesh->friendlyName = "crowd_agent";
+        member.mesh->doNotLight = false;
+        member.mesh->isVisible = true;
+        member.mesh->useRGBAColour = true;
+        member.mesh->RGBAColour = glm::vec4(0, 30, 50, 1);
+        member.mesh->scale = agent->scale;
+        member.mesh->rotation = agent->rotation;
+        member.cell = startCells[i];
+
+        crowd.push_back(member);
     }
+}
 
-    // Initialize a 2D vector of size 64x64
-    std::vector<std::vector<glm::vec3>> v1(64, std::vector<glm::vec3>(64)); 
+// Routes the whole crowd from where it stands, with one search from the
+// goals instead of one search per agent
+void RouteCrowd(void) {
 
-    // Copy over the 1D vector into the 2D vector
-    for (int i = 0; i < 64; i++) {
-        for (int j = 0; j < 64; j++) {
-            v1[i][j] = localgraph[i * 64 + j];
-        }
+    if (crowd.empty())
+        return;
+
+    std::vector<Pair> sources(crowd.size());
+    for (int i = 0; i < crowd.size(); i++) {
+        sources[i] = crowd[i].cell;
     }
 
-    v = v1;
+    A_STAR batch;
+    batch.SetAgentSize(AGENT_SIZE);
+    batch.batchSearch(pathGrid, sources, goalCells);
+
+    // The paths are moved into place, the iterators point at them
+    std::vector<cCompactPath>& routes = batch.GetBatchPaths();
+    for (int i = 0; i < crowd.size(); i++) {
+        crowd[i].path = routes[i];
+        crowd[i].step = crowd[i].path.begin();
+    }
+}
 
-    int breakpoint = 0;
+// True if the rest of a path can still be walked. Checks the same rules
+// as the searches: room for the agent on every cell, and no cutting the
+// corner of a wall on diagonal steps.
+bool PathIsClear(const cCompactPath& route, cCompactPath::Iterator step) {
+
+    auto isOpen = [](int row, int col) {
+        if (AGENT_SIZE > 1)
+            return pathGrid.Clearance(row, col) >= AGENT_SIZE;
+        return pathGrid.IsWalkable(row, col);
+    };
+
+    Pair last = *step;
+
+    for (cCompactPath::Iterator it = step; it != route.end(); ++it) {
+        Pair cell = *it;
+
+        if (!isOpen(cell.first, cell.second))
+            return false;
+
+        if (cell.first != last.first && cell.second != last.second
+            && (!isOpen(last.first, cell.second) || !isOpen(cell.first, last.second)))
+            return false;
+
+        last = cell;
+    }
 
-    bmpStream.close();
     return true;
 }
 
-void GenerateCubes(glm::vec3& startPos, float tileSize, std::vector<cMeshInfo*>& blocks) {
+// Cell under the cursor, on the plane through the centres of the cubes
+bool PickCell(const glm::mat4& view, const glm::mat4& projection, Pair& cell) {
 
-    glm::vec3 temp = startPos;
+    if (positions.empty())
+        return false;
 
-    startPos.y += 40.f;
+    int windowWidth, windowHeight;
+    glfwGetWindowSize(window, &windowWidth, &windowHeight);
 
-    for (int i = 0; i < graph.size(); i++) {
-        for (int j = 0; j < graph[i].size(); j++) {
-            positions[i][j] = startPos;
+    // Captured cursors don't point anywhere, use the centre of the screen
+    double cursorX = windowWidth * 0.5;
+    double cursorY = windowHeight * 0.5;
+    if (glfwGetInputMode(window, GLFW_CURSOR) == GLFW_CURSOR_NORMAL) {
+        glfwGetCursorPos(window, &cursorX, &cursorY);
+    }
 
-            if (graph[i][j] == glm::vec3(0, 0, 0)) {
+    glm::vec4 viewport(0.f, 0.f, (float)windowWidth, (float)windowHeight);
+    glm::vec3 screen((float)cursorX, (float)(windowHeight - cursorY), 0.f);
 
-                cube = new cMeshInfo();
-                cube->meshName = "wall_cube";
-                cube->friendlyName = "wall_cube";
-                cube->useRGBAColour = true;
-                cube->RGBAColour = glm::vec4(0.f, 0.f, 0.f, 1.f);
-                cube->SetUniformScale(tileSize);
-                cube->SetRotationFromEuler(origin);
+    glm::vec3 nearPoint = glm::unProject(screen, view, projection, viewport);
+    screen.z = 1.f;
+    glm::vec3 farPoint = glm::unProject(screen, view, projection, viewport);
 
-                cube->position = startPos;
-                blocks.push_back(cube);
+    glm::vec3 direction = farPoint - nearPoint;
+    glm::vec3 origin = positions[0][0];
 
-                startPos.x += tileSize;
-            }
-            else if (graph[i][j] == glm::vec3(36, 28, 237)) {
+    if (fabs(direction.y) < 1.e-6f)
+        return false;
 
-                cube = new cMeshInfo();
-                cube->meshName = "wall_cube";
-                cube->friendlyName = "wall_cube";
-                cube->useRGBAColour = true;
-                cube->RGBAColour = glm::vec4(10, 0, 0, 1.f);
-                cube->SetUniformScale(tileSize);
-                cube->SetRotationFromEuler(origin);
+    float t = (origin.y - nearPoint.y) / direction.y;
+    if (t < 0.f)
+        return false;
 
-                cube->position = startPos;
-                blocks.push_back(cube);
+    glm::vec3 hit = nearPoint + direction * t;
 
-                startPos.x += 75.f;
-            }
-            else if (graph[i][j] == glm::vec3(76, 177, 34)) {
+    cell.first = (int)floor((hit.z - origin.z) / WALL_TILE_SIZE + 0.5f);
+    cell.second = (int)floor((hit.x - origin.x) / WALL_TILE_SIZE + 0.5f);
 
-                cube = new cMeshInfo();
-                cube->meshName = "wall_cube";
-                cube->friendlyName = "wall_cube";
-                cube->useRGBAColour = true;
-                cube->RGBAColour = glm::vec4(0, 10, 0, 1.f);
-                cube->SetUniformScale(tileSize);
-                cube->SetRotationFromEuler(origin);
+    return pathGrid.IsInside(cell.first, cell.second);
+}
 
-                cube->position = startPos;
-                blocks.push_back(cube);
+// Toggles the wall of a cell and passes the change on to the grid, the
+// search structures, the wall cubes and the agent's path
+void EditCell(Pair cell) {
 
-                startPos.x += tileSize;
-            }
-            else {
-                startPos.x += tileSize;
-            }
+    // Starts, goals and the agents themselves stay open. The real-time
+    // agent is on the map even when the full path search found nothing.
+    if (cell == srcCell || cell == destCell) {
+        return;
+    }
+    if (theAgentMode == REAL_TIME_SEARCH) {
+        if (cell == realTimeSearch->GetRealTimePosition())
+            return;
+    }
+    else if (cell == pathAgentCell) {
+        return;
+    }
+    if (std::find(startCells.begin(), startCells.end(), cell) != startCells.end()
+        || std::find(goalCells.begin(), goalCells.end(), cell) != goalCells.end()) {
+        return;
+    }
+    for (int i = 0; i < crowd.size(); i++) {
+        if (crowd[i].cell == cell)
+            return;
+    }
+
+    if (!mapEditor.ToggleWall(cell.first, cell.second)) {
+        return;
+    }
+
+    bool isWall = !pathGrid.IsWalkable(cell.first, cell.second);
+
+    int& wall = cellCubes[cell.first][cell.second];
+    if (wall == NO_CUBE && isWall) {
+        wall = cubes->AddInstance(positions[cell.first][cell.second], WALL_TILE_SIZE, glm::vec4(0.f, 0.f, 0.f, 1.f));
+    }
+    else if (wall != NO_CUBE) {
+        cubes->SetVisible(wall, isWall);
+    }
+
+    // Replan when the agent's way is blocked, or when an earlier edit cut
+    // it off and this one may have opened a way again. Done in either
+    // mode, so switching back never follows a stale path.
+    if (path.Empty() || !PathIsClear(path, pathStep)) {
+        PlanPath(pathAgentCell, false);
+
+        if (path.Empty()) {
+            std::cout << "No path to the goal anymore." << std::endl;
         }
-        startPos.x = temp.x;
-        startPos.z += tileSize;
     }
-    int breakPoint = 0;
+
+    // An opened wall can make what the real-time agent learned too high,
+    // it would keep detouring around where the wall used to be
+    if (!isWall) {
+        realTimeSearch->ForgetLearnedHeuristic();
+    }
+
+    // The crowd is rerouted as a whole, and only if someone is blocked,
+    // or has been cut off and the wall that opened may let them through
+    for (int i = 0; i < crowd.size(); i++) {
+        bool reroute = crowd[i].path.Empty() ? !isWall : !PathIsClear(crowd[i].path, crowd[i].step);
+
+        if (reroute) {
+            RouteCrowd();
+            break;
+        }
+    }
+
+    const sMapEditStats& stats = mapEditor.GetLastEditStats();
+    std::cout << "Cell (" << cell.first << ", " << cell.second << ") is now " << (isWall ? "a wall" : "open")
+              << ", " << stats.clearanceCells << " clearance and " << stats.symmetryCells << " symmetry cells updated" << std::endl;
 }
 
 // All lights managed here
@@ -1092,49 +1399,143 @@ bool RandomizePositions(cMeshInfo* mesh) {
     return true;
 }
 
-void LoadPlyFilesIntoVAO(void)
-{
-    sModelDrawInfo bulb;
-    plyLoader->LoadModel(meshFiles[0], bulb);
-    if (!VAOMan->LoadModelIntoVAO("bulb", bulb, shaderID)) {
-        std::cerr << "Could not load model into VAO" << std::endl;
-    }
+// The binary files are written next to the originals first, so a failed
+// conversion never leaves a model half written
+bool ConvertMeshesToBinary(void) {
 
-    sModelDrawInfo flat_plain_obj;
-    plyLoader->LoadModel(meshFiles[9], flat_plain_obj);
-    if (!VAOMan->LoadModelIntoVAO("flat_plain", flat_plain_obj, shaderID)) {
-        std::cerr << "Could not load model into VAO" << std::endl;
-    }
+    ReadFromFile("./File Stream/readFile.txt");
+
+    bool converted = true;
+    for (int i = 0; i < meshFiles.size(); i++) {
+        if (std::find(meshFiles.begin(), meshFiles.begin() + i, meshFiles[i]) != meshFiles.begin() + i)
+            continue;
+
+        std::string tempFile = meshFiles[i] + ".tmp";
+        if (!PlyFileLoader::ConvertToBinary(meshFiles[i], tempFile)) {
+            std::remove(tempFile.c_str());
+            converted = false;
+            continue;
+        }
 
-    sModelDrawInfo wall_cube;
-    plyLoader->LoadModel(meshFiles[2], wall_cube);
-    if (!VAOMan->LoadModelIntoVAO("wall_cube", wall_cube, shaderID)) {
-        std::cerr << "Could not load model into VAO" << std::endl;
+        std::remove(meshFiles[i].c_str());
+        if (std::rename(tempFile.c_str(), meshFiles[i].c_str()) != 0) {
+            std::cout << "Could not replace " << meshFiles[i] << std::endl;
+            converted = false;
+        }
     }
-    
-    sModelDrawInfo pyramid;
-    plyLoader->LoadModel(meshFiles[11], pyramid);
-    if (!VAOMan->LoadModelIntoVAO("pyramid", pyramid, shaderID)) {
-        std::cerr << "Could not load model into VAO" << std::endl;
+
+    return converted;
+}
+
+// What cMeshOptimizer and cMeshSimplifier do to every model, straight
+// from the PLY files
+void ReportMeshOptimization(void) {
+
+    ReadFromFile("./File Stream/readFile.txt");
+
+    for (int i = 0; i < meshFiles.size(); i++) {
+        if (std::find(meshFiles.begin(), meshFiles.begin() + i, meshFiles[i]) != meshFiles.begin() + i)
+            continue;
+
+        sModelDrawInfo model;
+        if (!PlyFileLoader::Parse(meshFiles[i], model))
+            continue;
+
+        sMeshOptimizeStats stats;
+        cMeshOptimizer::Optimize(model, stats);
+
+        std::cout << meshFiles[i] << ": " << model.numberOfTriangles << " triangles, "
+            << stats.verticesBefore << " -> " << stats.verticesAfter << " vertices, ACMR "
+            << stats.acmrBefore << " -> " << stats.acmrAfter << std::endl;
+
+        model.CalculateExtents();
+        cMeshSimplifier::BuildLODs(model);
+
+        for (unsigned int level = 0; level < model.numberOfLODs; level++) {
+            std::cout << "    LOD " << level + 1 << ": " << model.lods[level].numberOfIndices / 3
+                << " triangles, error " << model.lods[level].error << std::endl;
+        }
+
+        model.ReleaseArrays();
     }
-    
+}
+
+// Meshes are parsed in parallel, and uploaded to the GPU here on the
+// main thread as each one is ready
+void LoadPlyFilesIntoVAO(void)
+{
+    cMeshLoadQueue meshQueue;
+
+    meshQueue.Add("bulb", meshFiles[0]);
+    meshQueue.Add("flat_plain", meshFiles[9]);
+    meshQueue.Add("wall_cube", meshFiles[2]);
+    meshQueue.Add("pyramid", meshFiles[11]);
+
     // 2-sided full screen quad aligned to x-y axis
-    sModelDrawInfo fullScreenQuad;
-    plyLoader->LoadModel(meshFiles[10], fullScreenQuad);
-    if (!VAOMan->LoadModelIntoVAO("fullScreenQuad", fullScreenQuad, shaderID)) {
-        std::cerr << "Could not load model into VAO" << std::endl;
-    }
+    meshQueue.Add("fullScreenQuad", meshFiles[10]);
 
     // skybox sphere with inverted normals
-    sModelDrawInfo skybox_sphere_obj;
-    plyLoader->LoadModel(meshFiles[6], skybox_sphere_obj);
-    if (!VAOMan->LoadModelIntoVAO("skybox_sphere", skybox_sphere_obj, shaderID)) {
-        std::cerr << "Could not load model into VAO" << std::endl;
+    meshQueue.Add("skybox_sphere", meshFiles[6]);
+
+    unsigned int cookFlags = 0;
+    if (OPTIMIZE_MESHES) {
+        cookFlags |= cMeshCache::FLAG_OPTIMIZED;
+    }
+    if (BUILD_MESH_LODS) {
+        cookFlags |= cMeshCache::FLAG_LODS;
     }
+
+    meshQueue.SetCookFlags(cookFlags);
+    meshQueue.Start(0);
+    meshQueue.UploadAll(VAOMan, shaderID);
+    // Uploading binds the models' VAOs behind DrawMesh's back
+    InvalidateBoundVAO();
+
+    std::cout << "Meshes loaded in " << meshQueue.TotalMilliseconds() << " ms" << std::endl;
+    VAOMan->PrintMemoryReport();
 }
 
 int main(int argc, char** argv) 
 {
+    // Time the grid layouts on large random maps, no window needed
+    if (argc > 1 && std::string(argv[1]) == "--benchmark") {
+        BenchmarkGridLayouts(1024, 1024, 20);
+        return 0;
+    }
+
+    // Search a world paged in from disk, with a 2 MB tile budget
+    if (argc > 1 && std::string(argv[1]) == "--benchmark-chunked") {
+        BenchmarkChunkedMap(16384, 16384, 2 * 1024 * 1024, 10);
+        return 0;
+    }
+
+    // Precompile a map: --convert-map <map.bmp> <map.grid>
+    if (argc > 3 && std::string(argv[1]) == "--convert-map") {
+        cGridFile gridFile;
+        if (!gridFile.Convert(argv[2], argv[3], PATH_GRID_LAYOUT)) {
+            std::cout << "Could not convert " << argv[2] << ": " << gridFile.getLastError() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // Turn a model into binary PLY: --convert-ply <in.ply> <out.ply>
+    if (argc > 3 && std::string(argv[1]) == "--convert-ply") {
+        return PlyFileLoader::ConvertToBinary(argv[2], argv[3]) ? 0 : 1;
+    }
+
+    // Every model the scene loads, converted to binary in place
+    if (argc > 1 && std::string(argv[1]) == "--convert-meshes") {
+        return ConvertMeshesToBinary() ? 0 : 1;
+    }
+
+    // ACMR of every model before and after optimizing, and its LODs,
+    // nothing is cooked
+    if (argc > 1 && std::string(argv[1]) == "--mesh-report") {
+        ReportMeshOptimization();
+        return 0;
+    }
+
     Initialize();
     Render();
     
@@ -11,6 +11,10 @@ in vec4 vBiNormal;
 in vec4 vBoneID;
 in vec4 vBoneWeight;
 
+// Per instance, see cInstancedMesh
+in vec4 vInstancePositionScale;
+in vec4 vInstanceColour;
+
 // Out to the geometry shader
 out vec4 gColour;
 out vec4 gNormal;
@@ -27,21 +31,63 @@ uniform mat4 ModelInverse;
 uniform mat4 View;
 uniform mat4 Projection;
 
+// Set for models uploaded as sPackedVertex: the position is a 0 to 1
+// fraction of the model's bounds and the normal is octahedral
+uniform bool bQuantizedVertex;
+uniform vec4 meshBoundsMin;
+uniform vec4 meshBoundsExtent;
+
+// Drawn with glDrawElementsInstanced: every instance is the model moved
+// to vInstancePositionScale.xyz and scaled by .w, no rotation, so Model
+// isn't used and the normals stay as they are
+uniform bool bIsInstanced;
+
+vec3 decodeOctahedral(vec2 e)
+{
+	vec3 n = vec3(e.xy, 1.f - abs(e.x) - abs(e.y));
+	if (n.z < 0.f)
+	{
+		vec2 signs = vec2(e.x >= 0.f ? 1.f : -1.f, e.y >= 0.f ? 1.f : -1.f);
+		n.xy = (1.f - abs(e.yx)) * signs;
+	}
+	return normalize(n);
+}
+
 void main()
 {
 	vec3 vertPosition = vPosition.xyz;
+	vec3 vertNormal = vNormal.xyz;
+
+	if (bQuantizedVertex)
+	{
+		vertPosition = meshBoundsMin.xyz + vPosition.xyz * meshBoundsExtent.xyz;
+		vertNormal = decodeOctahedral(vNormal.xy);
+	}
+
+	if (bIsInstanced)
+	{
+		vec3 worldPosition = vInstancePositionScale.xyz + vertPosition * vInstancePositionScale.w;
+
+		gl_Position = Projection * View * vec4(worldPosition, 1.f);
 
-	mat4 MVP = Projection * View * Model;
+		gWorldLocation = vec4(worldPosition, 1.f);
+		gNormal = vec4(normalize(vertNormal), 1.f);
+		gColour = vInstanceColour;
+	}
+	else
+	{
+		mat4 MVP = Projection * View * Model;
 	
-	gl_Position = MVP * vec4(vertPosition, 1.f);
+		gl_Position = MVP * vec4(vertPosition, 1.f);
 
-	gWorldLocation.xyz = (Model * vec4(vPosition)).xyz;
-	gWorldLocation.w = 1.f;
+		gWorldLocation.xyz = (Model * vec4(vertPosition, 1.f)).xyz;
+		gWorldLocation.w = 1.f;
 
-	gNormal.xyz = normalize(ModelInverse * vec4(vNormal.xyz, 1.f)).xyz;
-	gNormal.w = 1.f;
+		gNormal.xyz = normalize(ModelInverse * vec4(vertNormal, 1.f)).xyz;
+		gNormal.w = 1.f;
 
-	gColour = vColour;
+		gColour = vColour;
+	}
 	gUV2 = vUV2;
 	gTangent = vTangent;
 	gBiNormal = vBiNormal;